@@ -2,7 +2,18 @@
 #include <boost/test/included/unit_test.hpp>
 
 #include "../DLLReferencesResolver.hpp"
+#include "../PEFileUtils.hpp"
+#include "../SystemDLLBaseline.hpp"
+#include "../UserProfileEnvironmentUtils.hpp"
+#include "../ZipArchive.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cwctype>
 #include <filesystem>
+#include <fstream>
+#include <functional>
+#include <zlib.h>
 
 std::filesystem::path test_files_directory = std::filesystem::absolute("Test Files");
 
@@ -61,6 +72,68 @@ BOOST_AUTO_TEST_CASE(test_parsing_with_system_libraries)
     BOOST_REQUIRE(referenced_dlls_2.size() == 42);
 }
 
+// Packs the top-level test files which make up the application directory of Bot-Utilities.exe
+class bot_utilities_archive_fixture
+{
+    public:
+        std::filesystem::path archive_file_path = test_files_directory / "Bot-Utilities.zip";
+
+        bot_utilities_archive_fixture()
+        {
+            const auto command = "powershell -NoProfile -Command \"Compress-Archive -Force"
+                " -Path '" + (test_files_directory / "*.exe").string() + "','" + (test_files_directory / "*.dll").string() + "'"
+                " -DestinationPath '" + archive_file_path.string() + "'\"";
+            BOOST_REQUIRE(std::system(command.c_str()) == 0);
+        }
+
+        ~bot_utilities_archive_fixture()
+        {
+            std::error_code error_code;
+            std::filesystem::remove(archive_file_path, error_code);
+        }
+};
+
+inline std::vector<std::wstring> replace_file_path_prefix(std::vector<std::wstring> file_paths,
+                                                          const std::filesystem::path& prefix, const std::filesystem::path& replacement)
+{
+    const auto prefix_string = replace_user_profile_with_environment_variable(prefix).wstring();
+    const auto replacement_string = replace_user_profile_with_environment_variable(replacement).wstring();
+    for (auto& file_path : file_paths)
+    {
+        // The extracted file paths have their casing corrected
+        if (file_path.size() >= prefix_string.size() && std::equal(prefix_string.begin(), prefix_string.end(), file_path.begin(),
+            [](const wchar_t first, const wchar_t second) { return std::towlower(first) == std::towlower(second); }))
+        {
+            file_path.replace(0, prefix_string.size(), replacement_string);
+        }
+    }
+    std::ranges::sort(file_paths);
+    return file_paths;
+}
+
+BOOST_FIXTURE_TEST_CASE(test_zip_archive_parsing, bot_utilities_archive_fixture)
+{
+    dll_references_resolver references_resolver;
+    references_resolver.executable_file_path = test_files_directory / "Bot-Utilities.exe";
+    references_resolver.skip_parsing_windows_dll_dependencies = true;
+    const auto extracted_results = references_resolver.resolve_references();
+
+    // Mixed separators and relative segments must not matter
+    references_resolver.executable_file_path = test_files_directory.generic_wstring() + L"/Bot-Utilities.zip/../Bot-Utilities.zip/Bot-Utilities.exe";
+    const auto archive_results = references_resolver.resolve_references();
+    BOOST_REQUIRE(archive_results.dll_load_failures.size() == 1);
+    BOOST_REQUIRE(archive_results.missing_dlls.size() == 11);
+    BOOST_REQUIRE(archive_results.referenced_dlls.size() == 30);
+
+    // The archive must yield the same results as the extracted files, only the application directory differs
+    BOOST_REQUIRE(replace_file_path_prefix(archive_results.dll_load_failures, archive_file_path, test_files_directory)
+        == replace_file_path_prefix(extracted_results.dll_load_failures, archive_file_path, test_files_directory));
+    BOOST_REQUIRE(replace_file_path_prefix(archive_results.missing_dlls, archive_file_path, test_files_directory)
+        == replace_file_path_prefix(extracted_results.missing_dlls, archive_file_path, test_files_directory));
+    BOOST_REQUIRE(replace_file_path_prefix(archive_results.referenced_dlls, archive_file_path, test_files_directory)
+        == replace_file_path_prefix(extracted_results.referenced_dlls, archive_file_path, test_files_directory));
+}
+
 BOOST_AUTO_TEST_CASE(test_jduel_links_bot_hooks_parsing)
 {
     dll_references_resolver references_resolver;
@@ -70,4 +143,520 @@ BOOST_AUTO_TEST_CASE(test_jduel_links_bot_hooks_parsing)
     BOOST_REQUIRE(dll_load_failures.empty());
     BOOST_REQUIRE(missing_dlls.empty());
     BOOST_REQUIRE(referenced_dlls.size() == 3);
+}
+
+// Builds a baseline of a directory holding a single copied system DLL, its system dependencies are pulled in as well
+class system_dll_baseline_fixture
+{
+    public:
+        std::filesystem::path fixture_directory = test_files_directory / "Baseline Fixture";
+
+        std::filesystem::path module_file_path = fixture_directory / "version.dll";
+
+        std::filesystem::path baseline_file_path = fixture_directory / "Baseline.bin";
+
+        system_dll_baseline_fixture()
+        {
+            std::filesystem::remove_all(fixture_directory);
+            std::filesystem::create_directories(fixture_directory);
+            std::filesystem::copy_file(get_system_directory() / "version.dll", module_file_path);
+            build_system_dll_baseline(fixture_directory, baseline_file_path);
+        }
+
+        ~system_dll_baseline_fixture()
+        {
+            std::error_code error_code;
+            std::filesystem::remove_all(fixture_directory, error_code);
+        }
+
+        [[nodiscard]] resolved_dll_dependencies resolve_references(dll_references_resolver& references_resolver,
+                                                                   const bool use_baseline) const
+        {
+            references_resolver.executable_file_path = module_file_path;
+            references_resolver.baseline_file_path = use_baseline ? baseline_file_path : std::filesystem::path();
+            return references_resolver.resolve_references();
+        }
+
+        void write_modified_baseline(const std::function<void(std::string&)>& modify) const
+        {
+            std::ifstream file_reader(baseline_file_path, std::ios::binary);
+            std::string baseline_contents{ std::istreambuf_iterator(file_reader), std::istreambuf_iterator<char>() };
+            file_reader.close();
+
+            modify(baseline_contents);
+            std::ofstream file_writer(baseline_file_path, std::ios::binary | std::ios::trunc);
+            file_writer << baseline_contents;
+        }
+};
+
+inline void require_same_results(const resolved_dll_dependencies& results, const resolved_dll_dependencies& expected_results)
+{
+    BOOST_REQUIRE(results.dll_load_failures == expected_results.dll_load_failures);
+    BOOST_REQUIRE(results.missing_dlls == expected_results.missing_dlls);
+    BOOST_REQUIRE(results.referenced_dlls == expected_results.referenced_dlls);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_parsing_with_system_dll_baseline, system_dll_baseline_fixture)
+{
+    dll_references_resolver references_resolver;
+    const auto parsed_results = resolve_references(references_resolver, false);
+    BOOST_REQUIRE(references_resolver.get_baseline_module_file_paths().empty());
+
+    // The baseline must yield the same results as parsing without any module being parsed
+    const auto baseline_results = resolve_references(references_resolver, true);
+    require_same_results(baseline_results, parsed_results);
+    BOOST_REQUIRE(references_resolver.get_baseline_module_file_paths().contains(module_file_path));
+    BOOST_REQUIRE(references_resolver.get_baseline_module_file_paths().size() > 1);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_parsing_with_outdated_system_dll_baseline, system_dll_baseline_fixture)
+{
+    dll_references_resolver references_resolver;
+    const auto parsed_results = resolve_references(references_resolver, false);
+
+    // Changed modules are parsed again while their unchanged dependencies still come from the baseline
+    last_write_time(module_file_path, last_write_time(module_file_path) + std::chrono::hours(1));
+    const auto baseline_results = resolve_references(references_resolver, true);
+    require_same_results(baseline_results, parsed_results);
+    BOOST_REQUIRE(!references_resolver.get_baseline_module_file_paths().contains(module_file_path));
+    BOOST_REQUIRE(!references_resolver.get_baseline_module_file_paths().empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(test_truncated_system_dll_baseline, system_dll_baseline_fixture)
+{
+    write_modified_baseline([](std::string& baseline_contents)
+    {
+        baseline_contents.resize(baseline_contents.size() / 2);
+    });
+
+    dll_references_resolver references_resolver;
+    BOOST_REQUIRE_THROW(static_cast<void>(resolve_references(references_resolver, true)), std::runtime_error);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_wrong_version_system_dll_baseline, system_dll_baseline_fixture)
+{
+    // The version follows the 8 byte magic
+    write_modified_baseline([](std::string& baseline_contents)
+    {
+        baseline_contents[8] = static_cast<char>(baseline_contents[8] + 1);
+    });
+
+    dll_references_resolver references_resolver;
+    BOOST_REQUIRE_THROW(static_cast<void>(resolve_references(references_resolver, true)), std::runtime_error);
+}
+
+class zip_test_entry
+{
+    public:
+        std::string name;
+
+        std::string contents;
+
+        bool deflate = false;
+
+        bool zip64 = false;
+
+        bool encrypted = false;
+
+        bool corrupt_crc32 = false;
+};
+
+template <typename T>
+void append_little_endian(std::string& archive_contents, const T value)
+{
+    archive_contents.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+inline std::string deflate_raw(const std::string& contents)
+{
+    z_stream stream{};
+    BOOST_REQUIRE(deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK);
+    std::string compressed_contents(deflateBound(&stream, static_cast<uLong>(contents.size())), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(contents.data()));
+    stream.avail_in = static_cast<uInt>(contents.size());
+    stream.next_out = reinterpret_cast<Bytef*>(compressed_contents.data());
+    stream.avail_out = static_cast<uInt>(compressed_contents.size());
+    BOOST_REQUIRE(deflate(&stream, Z_FINISH) == Z_STREAM_END);
+    compressed_contents.resize(stream.total_out);
+    deflateEnd(&stream);
+    return compressed_contents;
+}
+
+// Writes a minimal ZIP archive, ZIP64 entries move their sizes and offset into the ZIP64 extra field
+inline std::filesystem::path write_zip_archive(const std::string& file_name, const std::vector<zip_test_entry>& entries,
+                                               const bool write_end_of_central_directory = true)
+{
+    std::string archive_contents;
+    std::string central_directory;
+    for (const auto& entry : entries)
+    {
+        const auto compressed_contents = entry.deflate ? deflate_raw(entry.contents) : entry.contents;
+        auto crc32_value = static_cast<uint32_t>(crc32(0, reinterpret_cast<const Bytef*>(entry.contents.data()),
+            static_cast<uInt>(entry.contents.size())));
+        if (entry.corrupt_crc32)
+        {
+            crc32_value ^= 1;
+        }
+        const auto local_header_offset = static_cast<uint64_t>(archive_contents.size());
+        const uint16_t flags = entry.encrypted ? 1 : 0;
+        const uint16_t compression_method = entry.deflate ? 8 : 0;
+        const auto compressed_size = entry.zip64 ? UINT32_MAX : static_cast<uint32_t>(compressed_contents.size());
+        const auto uncompressed_size = entry.zip64 ? UINT32_MAX : static_cast<uint32_t>(entry.contents.size());
+
+        append_little_endian<uint32_t>(archive_contents, 0x04034B50);
+        append_little_endian<uint16_t>(archive_contents, 45);
+        append_little_endian<uint16_t>(archive_contents, flags);
+        append_little_endian<uint16_t>(archive_contents, compression_method);
+        append_little_endian<uint32_t>(archive_contents, 0);
+        append_little_endian<uint32_t>(archive_contents, crc32_value);
+        append_little_endian<uint32_t>(archive_contents, compressed_size);
+        append_little_endian<uint32_t>(archive_contents, uncompressed_size);
+        append_little_endian<uint16_t>(archive_contents, static_cast<uint16_t>(entry.name.size()));
+        append_little_endian<uint16_t>(archive_contents, 0);
+        archive_contents += entry.name;
+        archive_contents += compressed_contents;
+
+        append_little_endian<uint32_t>(central_directory, 0x02014B50);
+        append_little_endian<uint16_t>(central_directory, 45);
+        append_little_endian<uint16_t>(central_directory, 45);
+        append_little_endian<uint16_t>(central_directory, flags);
+        append_little_endian<uint16_t>(central_directory, compression_method);
+        append_little_endian<uint32_t>(central_directory, 0);
+        append_little_endian<uint32_t>(central_directory, crc32_value);
+        append_little_endian<uint32_t>(central_directory, compressed_size);
+        append_little_endian<uint32_t>(central_directory, uncompressed_size);
+        append_little_endian<uint16_t>(central_directory, static_cast<uint16_t>(entry.name.size()));
+        append_little_endian<uint16_t>(central_directory, static_cast<uint16_t>(entry.zip64 ? 28 : 0));
+        append_little_endian<uint16_t>(central_directory, 0);
+        append_little_endian<uint16_t>(central_directory, 0);
+        append_little_endian<uint16_t>(central_directory, 0);
+        append_little_endian<uint32_t>(central_directory, 0);
+        append_little_endian<uint32_t>(central_directory, entry.zip64 ? UINT32_MAX : static_cast<uint32_t>(local_header_offset));
+        central_directory += entry.name;
+        if (entry.zip64)
+        {
+            append_little_endian<uint16_t>(central_directory, 0x0001);
+            append_little_endian<uint16_t>(central_directory, 24);
+            append_little_endian<uint64_t>(central_directory, entry.contents.size());
+            append_little_endian<uint64_t>(central_directory, compressed_contents.size());
+            append_little_endian<uint64_t>(central_directory, local_header_offset);
+        }
+    }
+
+    const auto central_directory_offset = static_cast<uint32_t>(archive_contents.size());
+    archive_contents += central_directory;
+    if (write_end_of_central_directory)
+    {
+        append_little_endian<uint32_t>(archive_contents, 0x06054B50);
+        append_little_endian<uint16_t>(archive_contents, 0);
+        append_little_endian<uint16_t>(archive_contents, 0);
+        append_little_endian<uint16_t>(archive_contents, static_cast<uint16_t>(entries.size()));
+        append_little_endian<uint16_t>(archive_contents, static_cast<uint16_t>(entries.size()));
+        append_little_endian<uint32_t>(archive_contents, static_cast<uint32_t>(central_directory.size()));
+        append_little_endian<uint32_t>(archive_contents, central_directory_offset);
+        append_little_endian<uint16_t>(archive_contents, 0);
+    }
+
+    const auto archive_file_path = std::filesystem::temp_directory_path() / file_name;
+    std::ofstream file_writer(archive_file_path, std::ios::binary | std::ios::trunc);
+    file_writer << archive_contents;
+    return archive_file_path;
+}
+
+inline std::string load_zip_entry(const zip_archive& archive, const std::string& entry_name, bool& loaded)
+{
+    const auto entry = archive.find_entry(entry_name);
+    BOOST_REQUIRE(entry != nullptr);
+    std::vector<uint8_t> buffer;
+    loaded = archive.load_entry_to_buffer(*entry, buffer);
+    return { buffer.begin(), buffer.end() };
+}
+
+BOOST_AUTO_TEST_CASE(test_zip_archive_entries)
+{
+    const std::string contents = "MZ" + std::string(4096, 'A') + "Test Module";
+    const auto archive_file_path = write_zip_archive("DLL-Dependencies-Parser-Entries.zip", {
+        { "bin/Stored.dll", contents },
+        { "bin/Deflated.dll", contents, true },
+        { "bin/Zip64.dll", contents, true, true },
+        { "bin/", "" }
+    });
+
+    {
+        const zip_archive archive(archive_file_path);
+        auto loaded = false;
+        BOOST_REQUIRE(load_zip_entry(archive, "bin/Stored.dll", loaded) == contents && loaded);
+        BOOST_REQUIRE(load_zip_entry(archive, "BIN\\deflated.DLL", loaded) == contents && loaded);
+        BOOST_REQUIRE(load_zip_entry(archive, "bin/Zip64.dll", loaded) == contents && loaded);
+        BOOST_REQUIRE(archive.find_entry("bin/") == nullptr);
+        BOOST_REQUIRE(archive.find_entry("bin/Missing.dll") == nullptr);
+    }
+
+    std::filesystem::remove(archive_file_path);
+}
+
+BOOST_AUTO_TEST_CASE(test_zip_archive_invalid_entries)
+{
+    const auto archive_file_path = write_zip_archive("DLL-Dependencies-Parser-Invalid-Entries.zip", {
+        { "Corrupted.dll", "Test Module", true, false, false, true },
+        { "Encrypted.dll", "Test Module", false, false, true }
+    });
+
+    {
+        const zip_archive archive(archive_file_path);
+        auto loaded = true;
+        BOOST_REQUIRE(load_zip_entry(archive, "Corrupted.dll", loaded).empty() && !loaded);
+        loaded = true;
+        BOOST_REQUIRE(load_zip_entry(archive, "Encrypted.dll", loaded).empty() && !loaded);
+    }
+
+    std::filesystem::remove(archive_file_path);
+}
+
+BOOST_AUTO_TEST_CASE(test_zip_archive_without_end_of_central_directory)
+{
+    const auto archive_file_path = write_zip_archive("DLL-Dependencies-Parser-Truncated.zip", {
+        { "Module.dll", "Test Module" }
+    }, false);
+
+    BOOST_REQUIRE_THROW(zip_archive{ archive_file_path }, std::runtime_error);
+    std::filesystem::remove(archive_file_path);
+}
+
+constexpr uint16_t i386_machine = 0x14C;
+constexpr uint16_t amd64_machine = 0x8664;
+
+class pe_test_import
+{
+    public:
+        std::string module_name;
+
+        // Symbols starting with # are imported by ordinal
+        std::vector<std::string> symbols;
+};
+
+class pe_test_image
+{
+    public:
+        uint16_t machine = get_process_machine();
+
+        bool dll = true;
+
+        std::vector<pe_test_import> imports;
+
+        // Exported with the ordinals 1, 2, ... in this order
+        std::vector<std::string> exports;
+};
+
+template <typename T>
+void write_little_endian(std::string& contents, const size_t offset, const T value)
+{
+    std::memcpy(contents.data() + offset, &value, sizeof(T));
+}
+
+// Builds a PE image with a single section holding the export and the import directory
+inline std::string build_pe_image(const pe_test_image& image)
+{
+    constexpr uint32_t section_address = 0x1000;
+    constexpr uint32_t headers_size = 0x200;
+    std::string section_contents;
+    const auto reserve = [&](const size_t size)
+    {
+        const auto offset = section_contents.size();
+        section_contents.resize(offset + size);
+        return offset;
+    };
+    const auto append_string = [&](const std::string& value)
+    {
+        const auto offset = reserve(value.size() + 1);
+        std::memcpy(section_contents.data() + offset, value.data(), value.size());
+        return static_cast<uint32_t>(section_address + offset);
+    };
+
+    uint32_t export_directory_address = 0;
+    uint32_t export_directory_size = 0;
+    if (!image.exports.empty())
+    {
+        const auto export_count = static_cast<uint32_t>(image.exports.size());
+        const auto export_directory_offset = reserve(40);
+        const auto functions_offset = reserve(export_count * 4);
+        const auto names_offset = reserve(export_count * 4);
+        const auto name_ordinals_offset = reserve(export_count * 2);
+
+        // The loader binary searches the names so they must be sorted
+        std::vector<std::pair<std::string, uint16_t>> sorted_exports;
+        for (uint16_t export_index = 0; export_index < export_count; export_index++)
+        {
+            sorted_exports.emplace_back(image.exports[export_index], export_index);
+            write_little_endian<uint32_t>(section_contents, functions_offset + export_index * 4, section_address);
+        }
+        std::ranges::sort(sorted_exports);
+        for (uint32_t name_index = 0; name_index < export_count; name_index++)
+        {
+            write_little_endian<uint32_t>(section_contents, names_offset + name_index * 4, append_string(sorted_exports[name_index].first));
+            write_little_endian<uint16_t>(section_contents, name_ordinals_offset + name_index * 2, sorted_exports[name_index].second);
+        }
+
+        write_little_endian<uint32_t>(section_contents, export_directory_offset + 12, append_string("Test.dll"));
+        write_little_endian<uint32_t>(section_contents, export_directory_offset + 16, 1);
+        write_little_endian<uint32_t>(section_contents, export_directory_offset + 20, export_count);
+        write_little_endian<uint32_t>(section_contents, export_directory_offset + 24, export_count);
+        write_little_endian<uint32_t>(section_contents, export_directory_offset + 28, static_cast<uint32_t>(section_address + functions_offset));
+        write_little_endian<uint32_t>(section_contents, export_directory_offset + 32, static_cast<uint32_t>(section_address + names_offset));
+        write_little_endian<uint32_t>(section_contents, export_directory_offset + 36, static_cast<uint32_t>(section_address + name_ordinals_offset));
+        export_directory_address = static_cast<uint32_t>(section_address + export_directory_offset);
+        export_directory_size = static_cast<uint32_t>(section_contents.size() - export_directory_offset);
+    }
+
+    const auto is_pe32_plus = image.machine != i386_machine;
+    const size_t thunk_size = is_pe32_plus ? 8 : 4;
+    uint32_t import_directory_address = 0;
+    uint32_t import_directory_size = 0;
+    if (!image.imports.empty())
+    {
+        import_directory_size = static_cast<uint32_t>((image.imports.size() + 1) * 20);
+        const auto import_directory_offset = reserve(import_directory_size);
+        for (size_t import_index = 0; import_index < image.imports.size(); import_index++)
+        {
+            const auto& [module_name, symbols] = image.imports[import_index];
+            const auto lookup_table_offset = reserve((symbols.size() + 1) * thunk_size);
+            const auto address_table_offset = reserve((symbols.size() + 1) * thunk_size);
+            for (size_t symbol_index = 0; symbol_index < symbols.size(); symbol_index++)
+            {
+                uint64_t thunk;
+                if (symbols[symbol_index].starts_with('#'))
+                {
+                    thunk = std::stoul(symbols[symbol_index].substr(1)) | (is_pe32_plus ? 1ULL << 63 : 1ULL << 31);
+                }
+                else
+                {
+                    // Hint followed by the name
+                    thunk = append_string(std::string(2, '\0') + symbols[symbol_index]);
+                }
+
+                for (const auto table_offset : { lookup_table_offset, address_table_offset })
+                {
+                    if (is_pe32_plus)
+                    {
+                        write_little_endian<uint64_t>(section_contents, table_offset + symbol_index * thunk_size, thunk);
+                    }
+                    else
+                    {
+                        write_little_endian<uint32_t>(section_contents, table_offset + symbol_index * thunk_size, static_cast<uint32_t>(thunk));
+                    }
+                }
+            }
+
+            const auto descriptor_offset = import_directory_offset + import_index * 20;
+            write_little_endian<uint32_t>(section_contents, descriptor_offset, static_cast<uint32_t>(section_address + lookup_table_offset));
+            write_little_endian<uint32_t>(section_contents, descriptor_offset + 12, append_string(module_name));
+            write_little_endian<uint32_t>(section_contents, descriptor_offset + 16, static_cast<uint32_t>(section_address + address_table_offset));
+        }
+        import_directory_address = static_cast<uint32_t>(section_address + import_directory_offset);
+    }
+
+    const auto section_size = static_cast<uint32_t>(std::max<size_t>(section_contents.size(), 1));
+    const auto raw_section_size = (section_size + 0x1FF) & ~0x1FFU;
+    const auto image_size = section_address + ((section_size + 0xFFF) & ~0xFFFU);
+    section_contents.resize(raw_section_size);
+
+    constexpr uint32_t nt_headers_offset = 0x40;
+    constexpr uint32_t file_header_offset = nt_headers_offset + 4;
+    constexpr uint32_t optional_header_offset = file_header_offset + 20;
+    const uint16_t optional_header_size = is_pe32_plus ? 0xF0 : 0xE0;
+    const auto section_header_offset = optional_header_offset + optional_header_size;
+    const auto data_directories_offset = optional_header_offset + (is_pe32_plus ? 112 : 96);
+
+    std::string image_contents(headers_size, '\0');
+    write_little_endian<uint16_t>(image_contents, 0, 0x5A4D);
+    write_little_endian<uint32_t>(image_contents, 0x3C, nt_headers_offset);
+    write_little_endian<uint32_t>(image_contents, nt_headers_offset, 0x00004550);
+
+    write_little_endian<uint16_t>(image_contents, file_header_offset, image.machine);
+    write_little_endian<uint16_t>(image_contents, file_header_offset + 2, 1);
+    write_little_endian<uint16_t>(image_contents, file_header_offset + 16, optional_header_size);
+    write_little_endian<uint16_t>(image_contents, file_header_offset + 18,
+        static_cast<uint16_t>(0x0002 | (image.dll ? 0x2000 : 0) | (is_pe32_plus ? 0x0020 : 0x0100)));
+
+    write_little_endian<uint16_t>(image_contents, optional_header_offset, static_cast<uint16_t>(is_pe32_plus ? 0x20B : 0x10B));
+    write_little_endian<uint32_t>(image_contents, optional_header_offset + 8, raw_section_size);
+    if (is_pe32_plus)
+    {
+        write_little_endian<uint64_t>(image_contents, optional_header_offset + 24, image.dll ? 0x180000000ULL : 0x140000000ULL);
+    }
+    else
+    {
+        write_little_endian<uint32_t>(image_contents, optional_header_offset + 28, image.dll ? 0x10000000U : 0x400000U);
+    }
+    write_little_endian<uint32_t>(image_contents, optional_header_offset + 32, 0x1000);
+    write_little_endian<uint32_t>(image_contents, optional_header_offset + 36, 0x200);
+    write_little_endian<uint16_t>(image_contents, optional_header_offset + 40, 6);
+    write_little_endian<uint16_t>(image_contents, optional_header_offset + 48, 6);
+    write_little_endian<uint32_t>(image_contents, optional_header_offset + 56, image_size);
+    write_little_endian<uint32_t>(image_contents, optional_header_offset + 60, headers_size);
+    write_little_endian<uint16_t>(image_contents, optional_header_offset + 68, 3);
+    write_little_endian<uint32_t>(image_contents, optional_header_offset + (is_pe32_plus ? 108 : 92), 16);
+    write_little_endian<uint32_t>(image_contents, data_directories_offset, export_directory_address);
+    write_little_endian<uint32_t>(image_contents, data_directories_offset + 4, export_directory_size);
+    write_little_endian<uint32_t>(image_contents, data_directories_offset + 8, import_directory_address);
+    write_little_endian<uint32_t>(image_contents, data_directories_offset + 12, import_directory_size);
+
+    std::memcpy(image_contents.data() + section_header_offset, ".rdata", 6);
+    write_little_endian<uint32_t>(image_contents, section_header_offset + 8, section_size);
+    write_little_endian<uint32_t>(image_contents, section_header_offset + 12, section_address);
+    write_little_endian<uint32_t>(image_contents, section_header_offset + 16, raw_section_size);
+    write_little_endian<uint32_t>(image_contents, section_header_offset + 20, headers_size);
+    write_little_endian<uint32_t>(image_contents, section_header_offset + 36, 0x40000040);
+
+    return image_contents + section_contents;
+}
+
+BOOST_AUTO_TEST_CASE(test_zip_archive_module_loading)
+{
+    const auto foreign_machine = get_process_machine() == i386_machine ? amd64_machine : i386_machine;
+    const auto archive_file_path = write_zip_archive("DLL-Dependencies-Parser-Loading.zip", {
+        { "Application/Application.exe", build_pe_image({ get_process_machine(), false, {
+            { "Foreign.dll", { "Function" } },
+            { "NotADll.dll", { "Function" } },
+            { "MissingExport.dll", { "Function" } },
+            { "MissingSystemExport.dll", { "Function" } },
+            { "Loadable.dll", { "Function" } }
+        } }), true },
+        { "Application/Foreign.dll", build_pe_image({ foreign_machine, true, {}, { "Function" } }), true },
+        { "Application/NotADll.dll", build_pe_image({ get_process_machine(), false, {}, { "Function" } }), true },
+        { "Application/Library.dll", build_pe_image({ get_process_machine(), true, {}, { "Function", "Second" } }), true },
+        { "Application/MissingExport.dll", build_pe_image({ get_process_machine(), true, {
+            { "Library.dll", { "Function", "Missing" } }
+        }, { "Function" } }), true },
+        { "Application/MissingSystemExport.dll", build_pe_image({ get_process_machine(), true, {
+            { "kernel32.dll", { "GetTickCount", "DLLDependenciesParserMissingFunction" } }
+        }, { "Function" } }), true },
+        { "Application/Loadable.dll", build_pe_image({ get_process_machine(), true, {
+            { "kernel32.dll", { "GetTickCount" } },
+            { "Library.dll", { "Function", "#2" } }
+        }, { "Function" } }), true }
+    });
+
+    {
+        dll_references_resolver references_resolver;
+        references_resolver.executable_file_path = archive_file_path / "Application" / "Application.exe";
+        references_resolver.skip_parsing_windows_dll_dependencies = true;
+        auto [dll_load_failures, missing_dlls, referenced_dlls] = references_resolver.resolve_references();
+
+        // Just like LoadLibrary() fails on them for the extracted files, so they remain as module name
+        std::ranges::sort(dll_load_failures);
+        BOOST_REQUIRE(dll_load_failures == std::vector<std::wstring>({
+            L"Foreign.dll", L"MissingExport.dll", L"MissingSystemExport.dll", L"NotADll.dll"
+        }));
+        BOOST_REQUIRE(missing_dlls.empty());
+
+        for (const auto& loadable_module_name : { L"Library.dll", L"Loadable.dll" })
+        {
+            const auto loadable_module_file_path = replace_user_profile_with_environment_variable(
+                archive_file_path / "Application" / loadable_module_name).wstring();
+            BOOST_REQUIRE(std::ranges::find(referenced_dlls, loadable_module_file_path) != referenced_dlls.end());
+        }
+    }
+
+    std::filesystem::remove(archive_file_path);
 }
\ No newline at end of file
@@ -1,6 +1,6 @@
 #include "DLLReferencesResolver.hpp"
 
-#include <pe-parse/parse.h>
+#include <fstream>
 #include <CLI/CLI.hpp>
 #include <Windows.h>
 #include <spdlog/spdlog.h>
@@ -13,147 +13,186 @@ using json = nlohmann::json;
 
 #include "UserProfileEnvironmentUtils.hpp"
 #include "ExecutionTimer.hpp"
+#include "PEFileUtils.hpp"
 
-using parsed_pe_ref = std::unique_ptr<peparse::parsed_pe, void (*)(peparse::parsed_pe*)>;
+std::set<std::filesystem::path> module_file_paths;
 
-bool load_file_to_buffer(const std::filesystem::path& file_path, std::vector<uint8_t>& buffer)
+std::filesystem::path dll_references_resolver::resolve_absolute_dll_file_path(const std::filesystem::path& module_name) const
 {
-    // Open the file in binary mode
-    std::ifstream file(file_path, std::ios::binary | std::ios::ate);
-    if (!file)
+    // Only search the system directories so unrelated modules in the current directory are never loaded
+    if (const auto module_file_path = get_loaded_module_file_path(module_name, LOAD_LIBRARY_SEARCH_SYSTEM32);
+        !module_file_path.empty()
+        && boost::istarts_with(module_file_path.wstring(), get_windows_directory().wstring()))
     {
-        spdlog::error("Failed to open file: " + wide_string_to_string(file_path.wstring()));
-        return false;
+        return correct_path_casing(module_file_path);
     }
 
-    // Get the file size
-    const std::ifstream::pos_type file_size = file.tellg();
-    if (file_size <= 0)
+    // The Windows loader searches the application directory after the system directories
+    if (const auto module_file_path = module_file_source_->find_in_application_directory(module_name);
+        !module_file_path.empty() && module_file_source_->is_loadable(module_file_path))
     {
-        spdlog::error("File is empty or error in determining file size: " + wide_string_to_string(file_path.wstring()));
-        return false;
+        return module_file_path;
     }
 
-    // Resize the buffer to fit the file content
-    buffer.resize(file_size);
-
-    // Seek to the beginning and read the file into the buffer
-    file.seekg(0, std::ios::beg);
-    file.read(reinterpret_cast<char*>(buffer.data()), static_cast<long long>(buffer.size()));
+    return "";
+}
 
-    // Check if the read operation was successful
-    if (!file)
+std::filesystem::path dll_references_resolver::resolve_module_file_path(const std::filesystem::path& module_name) const
+{
+    // Modules which fail to load remain as module name, just like the Windows loader cannot report a path for them
+    if (const auto absolute_module_file_path = resolve_absolute_dll_file_path(module_name);
+        !absolute_module_file_path.empty())
     {
-        spdlog::error("Failed to read file: " + wide_string_to_string(file_path.wstring()));
-        buffer.clear();
-        return false;
+        return absolute_module_file_path;
     }
 
-    return true;
+    return module_name;
 }
 
-inline parsed_pe_ref open_executable(const std::filesystem::path& path)
+void dll_references_resolver::add_module_file_paths(const std::filesystem::path& parsed_module_file_path)
 {
-    std::vector<uint8_t> buffer;
-    if (!load_file_to_buffer(path, buffer))
+    parsed_module_file_paths_.insert(parsed_module_file_path);
+
+    const execution_timer timer;
+    spdlog::debug("Parsing PE file " + wide_string_to_string(parsed_module_file_path.wstring()) + "...");
+    std::set<std::string> imported_module_names;
+    if (!module_file_source_->load_imported_module_names(parsed_module_file_path, imported_module_names))
     {
-        return { nullptr, peparse::DestructParsedPE };
+        throw std::runtime_error("Failed parsing PE file " + wide_string_to_string(parsed_module_file_path.wstring()));
     }
 
-    const auto pe = peparse::ParsePEFromPointer(buffer.data(), static_cast<uint32_t>(buffer.size()));
-    return { pe, peparse::DestructParsedPE };
-}
-
-std::set<std::filesystem::path> module_file_paths;
-
-// ReSharper disable once CppParameterMayBeConstPtrOrRef
-inline auto dump_module_names(void* output_buffer, const peparse::VA& virtual_address,
-                              const std::string& module_name, const std::string& symbol_name)
-{
-    (void)output_buffer;
-    (void)virtual_address;
-    (void)symbol_name;
+    // Only the new imports need resolving, the module file paths collected so far are final
+    spdlog::debug("Resolving imported module names...");
+    std::set<std::filesystem::path> imported_module_file_paths;
+    for (const auto& imported_module_name : imported_module_names)
+    {
+        imported_module_file_paths.insert(resolve_module_file_path(imported_module_name));
+    }
 
-    module_file_paths.insert(module_name);
+    module_file_paths.insert(imported_module_file_paths.begin(), imported_module_file_paths.end());
 
-    // Continue iterating
-    return 0;
+    spdlog::debug("Module name count: " + std::to_string(module_file_paths.size()));
+    const auto timer_log_message = timer.build_log_message("Getting imported modules for " + wide_string_to_string(parsed_module_file_path.wstring()));
+    spdlog::debug(timer_log_message);
 }
 
-inline std::filesystem::path get_windows_directory()
+bool dll_references_resolver::add_baseline_module_file_paths(const std::filesystem::path& module_file_path)
 {
-    wchar_t file_path[MAX_PATH];
-    if (const auto length_copied = GetWindowsDirectory(file_path, MAX_PATH);
-        length_copied == 0)
+    const auto module_index = baseline_->find_module(module_file_path);
+    if (!module_index.has_value())
     {
-        throw std::runtime_error("GetWindowsDirectory() failed");
+        return false;
     }
-    return file_path;
-}
 
-std::filesystem::path dll_references_resolver::resolve_absolute_dll_file_path(const std::filesystem::path& module_name) const
-{
-    if (const auto module_handle = LoadLibrary(module_name.wstring().c_str());
-        module_handle != nullptr)
+    if (!baseline_->is_module_up_to_date(*module_index))
     {
-        wchar_t module_file_path[MAX_PATH];
-        GetModuleFileName(module_handle, module_file_path, MAX_PATH);
+        spdlog::debug("Baseline module " + wide_string_to_string(module_file_path.wstring()) + " changed, parsing it...");
+        return false;
+    }
 
-        // Freeing the library is expensive so don't do it
-        /* if (const auto freeing_succeeded = FreeLibrary(module_handle);
-            !freeing_succeeded)
+    const auto windows_directory = get_windows_directory();
+
+    // The module may have been passed with a different casing than recorded in the baseline
+    parsed_module_file_paths_.insert(module_file_path);
+
+    // Walk the whole subtree from the snapshot, only modules which changed since are left for parsing
+    std::vector pending_module_indices{ *module_index };
+    while (!pending_module_indices.empty())
+    {
+        const auto pending_module_index = pending_module_indices.back();
+        pending_module_indices.pop_back();
+
+        const auto baseline_module_file_path = baseline_->get_module_file_path(pending_module_index);
+        if (parsed_module_file_paths_.contains(baseline_module_file_path))
         {
-            std::cerr << "FreeLibrary() failed on " << module_name << "..." << std::endl;
-        } */
+            continue;
+        }
 
-        if (const auto windows_directory = get_windows_directory();
-            !boost::istarts_with(module_file_path, windows_directory.wstring())
-            && !boost::istarts_with(module_file_path, executable_file_path.parent_path().wstring()))
+        if (pending_module_index != *module_index
+            && !baseline_->is_module_up_to_date(pending_module_index))
         {
-            return "";
+            spdlog::debug("Baseline module " + wide_string_to_string(baseline_module_file_path.wstring()) + " changed, parsing it...");
+            module_file_paths.insert(baseline_module_file_path);
+            continue;
         }
 
-        return module_file_path;
+        spdlog::debug("Taking imported modules of " + wide_string_to_string(baseline_module_file_path.wstring()) + " from the baseline...");
+        parsed_module_file_paths_.insert(baseline_module_file_path);
+        baseline_module_file_paths_.insert(baseline_module_file_path);
+        // The loadability covers the whole import tree which may have changed since the baseline was built
+        if (baseline_->is_module_loadable(pending_module_index)
+            && is_baseline_module_tree_up_to_date(pending_module_index))
+        {
+            loadable_baseline_module_file_paths_.insert(baseline_module_file_path);
+        }
+
+        for (const auto& [module_name, resolved_file_path, imported_module_index] : baseline_->get_module_imports(pending_module_index))
+        {
+            if (resolved_file_path.empty())
+            {
+                module_file_paths.insert(resolve_module_file_path(module_name));
+                continue;
+            }
+
+            module_file_paths.insert(resolved_file_path);
+
+            if (imported_module_index.has_value()
+                && !(skip_parsing_windows_dll_dependencies
+                    && boost::istarts_with(resolved_file_path.wstring(), windows_directory.wstring())))
+            {
+                pending_module_indices.push_back(*imported_module_index);
+            }
+        }
     }
 
-    return "";
+    return true;
 }
 
-void dll_references_resolver::add_module_file_paths(const std::filesystem::path& parsed_module_file_path)
+bool dll_references_resolver::is_baseline_module_tree_up_to_date(const uint32_t module_index)
 {
-    parsed_module_file_paths_.insert(parsed_module_file_path);
-
-    const execution_timer timer;
-    spdlog::debug("Parsing PE file " + wide_string_to_string(parsed_module_file_path.wstring()) + "...");
-    const auto parsed_pe = open_executable(parsed_module_file_path);
-    if (!parsed_pe)
+    if (const auto up_to_date_module_tree = up_to_date_baseline_module_trees_.find(module_index);
+        up_to_date_module_tree != up_to_date_baseline_module_trees_.end())
     {
-        throw std::runtime_error("Failed parsing PE file " + wide_string_to_string(parsed_module_file_path.wstring()));
+        return up_to_date_module_tree->second;
     }
 
-    spdlog::debug("Dumping imported module names...");
-    IterImpVAString(parsed_pe.get(), &dump_module_names, nullptr);
-
-    std::set<std::filesystem::path> updated_module_file_paths;
-    for (auto& module_name : module_file_paths)
+    std::set visited_module_indices{ module_index };
+    std::vector pending_module_indices{ module_index };
+    while (!pending_module_indices.empty())
     {
-        if (const auto absolute_module_file_path = resolve_absolute_dll_file_path(module_name);
-            !absolute_module_file_path.empty())
+        const auto pending_module_index = pending_module_indices.back();
+        pending_module_indices.pop_back();
+
+        if (const auto up_to_date_module_tree = up_to_date_baseline_module_trees_.find(pending_module_index);
+            up_to_date_module_tree != up_to_date_baseline_module_trees_.end() && up_to_date_module_tree->second)
         {
-            const auto corrected_casing = correct_path_casing(absolute_module_file_path.wstring());
-            updated_module_file_paths.insert(corrected_casing);
+            continue;
         }
-        else
+
+        if (!baseline_->is_module_up_to_date(pending_module_index))
         {
-            updated_module_file_paths.insert(module_name);
+            spdlog::debug("Baseline module " + wide_string_to_string(baseline_->get_module_file_path(pending_module_index).wstring())
+                + " changed, checking the loading of its importers live...");
+            up_to_date_baseline_module_trees_.emplace(module_index, false);
+            return false;
         }
-    }
 
-    module_file_paths = updated_module_file_paths;
+        for (const auto& imported_module : baseline_->get_module_imports(pending_module_index))
+        {
+            const auto& imported_module_index = imported_module.module_index;
+            if (imported_module_index.has_value() && visited_module_indices.insert(*imported_module_index).second)
+            {
+                pending_module_indices.push_back(*imported_module_index);
+            }
+        }
+    }
 
-    spdlog::debug("Module name count: " + std::to_string(module_file_paths.size()));
-    const auto timer_log_message = timer.build_log_message("Getting imported modules for " + wide_string_to_string(parsed_module_file_path.wstring()));
-    spdlog::debug(timer_log_message);
+    // Every module reached is up to date so their own trees are as well
+    for (const auto visited_module_index : visited_module_indices)
+    {
+        up_to_date_baseline_module_trees_.emplace(visited_module_index, true);
+    }
+    return true;
 }
 
 inline auto write_to_file(const std::string& file_contents, const std::filesystem::path& file_path)
@@ -169,19 +208,30 @@ inline auto write_to_file(const std::string& file_contents, const std::filesyste
 resolved_dll_dependencies dll_references_resolver::resolve_references()
 {
     parsed_module_file_paths_.clear();
+    baseline_module_file_paths_.clear();
+    loadable_baseline_module_file_paths_.clear();
+    up_to_date_baseline_module_trees_.clear();
     module_file_paths.clear();
 
-    if (!is_regular_file(executable_file_path))
+    // Open the baseline before the current directory changes so relative paths keep working
+    baseline_.reset();
+    if (!baseline_file_path.empty())
     {
-        throw std::runtime_error("Input file \"" + wide_string_to_string(executable_file_path.wstring()) + "\" does not exist");
+        baseline_ = std::make_unique<system_dll_baseline>(baseline_file_path);
+        spdlog::info("Using baseline of " + wide_string_to_string(baseline_->get_system_directory().wstring())
+            + " with " + std::to_string(baseline_->get_module_count()) + " modules...");
     }
 
-    // Set the current directory to the executable's parent directory
-    const auto parent_file_path = executable_file_path.parent_path().wstring();
-    SetCurrentDirectory(parent_file_path.c_str());
+    // Normalize the path so it can be compared against the module file paths found inside archives
+    const auto input_file_path = absolute(executable_file_path).lexically_normal();
+    module_file_source_ = open_module_file_source(input_file_path);
+    if (!module_file_source_->exists(input_file_path))
+    {
+        throw std::runtime_error("Input file \"" + wide_string_to_string(executable_file_path.wstring()) + "\" does not exist");
+    }
 
     // Begin the modules iteration with the executable
-    module_file_paths.insert(executable_file_path.wstring());
+    module_file_paths.insert(input_file_path);
 
     std::set<std::filesystem::path> missing_dlls_file_names;
 
@@ -210,6 +260,11 @@ resolved_dll_dependencies dll_references_resolver::resolve_references()
 
             try
             {
+                if (baseline_ != nullptr && add_baseline_module_file_paths(module_file_path))
+                {
+                    continue;
+                }
+
                 add_module_file_paths(module_file_path);
             }
             catch (const std::exception& exception)
@@ -232,7 +287,8 @@ resolved_dll_dependencies dll_references_resolver::resolve_references()
     std::set<std::filesystem::path> dll_load_failures;
     for (const auto& module_file_path : module_file_paths)
     {
-        if (missing_dlls_file_names.contains(module_file_path))
+        if (missing_dlls_file_names.contains(module_file_path)
+            || loadable_baseline_module_file_paths_.contains(module_file_path))
         {
             continue;
         }
@@ -267,7 +323,7 @@ resolved_dll_dependencies dll_references_resolver::resolve_references()
     json referenced_dlls_json = json::array();
     std::vector<std::wstring> referenced_dlls_vector;
     // Exclude the PE file again
-    module_file_paths.erase(executable_file_path);
+    module_file_paths.erase(input_file_path);
     for (const auto& module_file_path : module_file_paths)
     {
     	if (boost::iends_with(module_file_path.wstring(), L".exe"))
@@ -294,4 +350,9 @@ resolved_dll_dependencies dll_references_resolver::resolve_references()
     spdlog::info(message);
 
     return { dll_load_failures_vector, missing_dlls_vector, referenced_dlls_vector };
+}
+
+const std::set<std::filesystem::path>& dll_references_resolver::get_baseline_module_file_paths() const
+{
+    return baseline_module_file_paths_;
 }
\ No newline at end of file
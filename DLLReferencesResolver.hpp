@@ -1,8 +1,14 @@
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
+#include <map>
+#include <memory>
 #include <set>
 
+#include "ModuleFileSource.hpp"
+#include "SystemDLLBaseline.hpp"
+
 class resolved_dll_dependencies
 {
 	public:
@@ -19,16 +25,40 @@ class dll_references_resolver
 {
 	[[nodiscard]] std::filesystem::path resolve_absolute_dll_file_path(const std::filesystem::path& module_name) const;
 
+	[[nodiscard]] std::filesystem::path resolve_module_file_path(const std::filesystem::path& module_name) const;
+
 	void add_module_file_paths(const std::filesystem::path& parsed_module_file_path);
 
+	bool add_baseline_module_file_paths(const std::filesystem::path& module_file_path);
+
+	// Whether every baseline module reachable from the module still matches its stamp
+	bool is_baseline_module_tree_up_to_date(uint32_t module_index);
+
 	std::set<std::filesystem::path> parsed_module_file_paths_;
 
+	std::set<std::filesystem::path> baseline_module_file_paths_;
+
+	std::set<std::filesystem::path> loadable_baseline_module_file_paths_;
+
+	std::map<uint32_t, bool> up_to_date_baseline_module_trees_;
+
+	std::unique_ptr<system_dll_baseline> baseline_;
+
+	std::unique_ptr<module_file_source> module_file_source_;
+
 	public:
+	    // May point inside a ZIP archive (e.g. D:\Release.zip\bin\Application.exe) which is then analyzed without extraction
 	    std::filesystem::path executable_file_path;
 
 	    std::filesystem::path results_output_file_path;
 
 	    bool skip_parsing_windows_dll_dependencies = default_skip_parsing_windows_dll_dependencies;
 
+	    // Optional snapshot built with build_system_dll_baseline() to answer system module lookups from
+	    std::filesystem::path baseline_file_path;
+
 		resolved_dll_dependencies resolve_references();
+
+		// The modules whose imports were taken from the baseline during the last resolve_references() call
+		[[nodiscard]] const std::set<std::filesystem::path>& get_baseline_module_file_paths() const;
 };
\ No newline at end of file
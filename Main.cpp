@@ -1,7 +1,9 @@
 #include <CLI/CLI.hpp>
 #include <spdlog/spdlog.h>
 #include "DLLReferencesResolver.hpp"
+#include "PEFileUtils.hpp"
 #include "StringUtils.hpp"
+#include "SystemDLLBaseline.hpp"
 
 inline std::string bool_to_string(const bool value)
 {
@@ -29,25 +31,50 @@ int wmain(const int argument_count, wchar_t* arguments[])
         CLI::App application{"Referenced DLL Parser"};
 
         std::filesystem::path executable_file_path;
-        application.add_option("--pe-file-path", executable_file_path, "The file path to the executable to analyze")
-        ->required()
-    	->check(CLI::ExistingFile);
+        const auto pe_file_path_option = application.add_option("--pe-file-path", executable_file_path, "The file path to the executable to analyze, may point inside a ZIP archive");
         auto skip_parsing_windows_dll_dependencies = default_skip_parsing_windows_dll_dependencies;
         application.add_flag("--skip-parsing-windows-dll-dependencies", skip_parsing_windows_dll_dependencies, "Whether Windows DLLs will not be parsed to speed up analysis");
         std::filesystem::path results_output_file_path;
         application.add_option("--results-output-file-path", results_output_file_path, "The output file to write the results to");
+        std::filesystem::path baseline_file_path;
+        application.add_option("--baseline", baseline_file_path, "A baseline file built with --build-baseline to look up system DLL dependencies in instead of parsing them")
+    	->check(CLI::ExistingFile);
+        std::filesystem::path build_baseline_file_path;
+        application.add_option("--build-baseline", build_baseline_file_path, "Scans the system directory once and writes the baseline file to the given path")
+    	->excludes(pe_file_path_option);
+        std::filesystem::path baseline_system_directory = get_system_directory();
+        application.add_option("--baseline-system-directory", baseline_system_directory, "The directory scanned by --build-baseline")
+        ->capture_default_str()
+    	->check(CLI::ExistingDirectory);
     	
         CLI11_PARSE(application, argument_count, arguments)
 
+        if (!build_baseline_file_path.empty())
+        {
+            build_system_dll_baseline(baseline_system_directory, absolute(build_baseline_file_path));
+            return EXIT_SUCCESS;
+        }
+
+        if (executable_file_path.empty())
+        {
+            throw std::runtime_error("Either --pe-file-path or --build-baseline is required");
+        }
+
         spdlog::info("Executable file path: " + wide_string_to_string(executable_file_path.wstring()));
         spdlog::info("Skip parsing Windows DLL dependencies: " + bool_to_string(skip_parsing_windows_dll_dependencies));
         results_output_file_path = absolute(results_output_file_path);
         spdlog::info("Results output file path: " + wide_string_to_string(results_output_file_path.wstring()));
+        if (!baseline_file_path.empty())
+        {
+            baseline_file_path = absolute(baseline_file_path);
+        }
+        spdlog::info("Baseline file path: " + wide_string_to_string(baseline_file_path.wstring()));
     	
         dll_references_resolver references_resolver;
         references_resolver.executable_file_path = executable_file_path;
         references_resolver.skip_parsing_windows_dll_dependencies = skip_parsing_windows_dll_dependencies;
         references_resolver.results_output_file_path = results_output_file_path;
+        references_resolver.baseline_file_path = baseline_file_path;
         references_resolver.resolve_references();
 
         return EXIT_SUCCESS;
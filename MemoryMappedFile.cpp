@@ -0,0 +1,57 @@
+#include "MemoryMappedFile.hpp"
+
+#include <stdexcept>
+#include <Windows.h>
+
+#include "StringUtils.hpp"
+
+memory_mapped_file::memory_mapped_file(const std::filesystem::path& file_path)
+{
+    file_handle_ = CreateFile(file_path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_handle_ == INVALID_HANDLE_VALUE)
+    {
+        file_handle_ = nullptr;
+        throw std::runtime_error("Failed to open file: " + wide_string_to_string(file_path.wstring()));
+    }
+
+    LARGE_INTEGER file_size{};
+    if (!GetFileSizeEx(file_handle_, &file_size) || file_size.QuadPart <= 0)
+    {
+        CloseHandle(file_handle_);
+        throw std::runtime_error("File is empty or error in determining file size: " + wide_string_to_string(file_path.wstring()));
+    }
+    size_ = static_cast<size_t>(file_size.QuadPart);
+
+    mapping_handle_ = CreateFileMapping(file_handle_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_handle_ == nullptr)
+    {
+        CloseHandle(file_handle_);
+        throw std::runtime_error("CreateFileMapping() failed on " + wide_string_to_string(file_path.wstring()));
+    }
+
+    data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_handle_, FILE_MAP_READ, 0, 0, 0));
+    if (data_ == nullptr)
+    {
+        CloseHandle(mapping_handle_);
+        CloseHandle(file_handle_);
+        throw std::runtime_error("MapViewOfFile() failed on " + wide_string_to_string(file_path.wstring()));
+    }
+}
+
+memory_mapped_file::~memory_mapped_file()
+{
+    UnmapViewOfFile(data_);
+    CloseHandle(mapping_handle_);
+    CloseHandle(file_handle_);
+}
+
+const uint8_t* memory_mapped_file::data() const
+{
+    return data_;
+}
+
+size_t memory_mapped_file::size() const
+{
+    return size_;
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+class memory_mapped_file
+{
+	void* file_handle_ = nullptr;
+
+	void* mapping_handle_ = nullptr;
+
+	const uint8_t* data_ = nullptr;
+
+	size_t size_ = 0;
+
+	public:
+		explicit memory_mapped_file(const std::filesystem::path& file_path);
+
+		~memory_mapped_file();
+
+		memory_mapped_file(const memory_mapped_file&) = delete;
+
+		memory_mapped_file& operator=(const memory_mapped_file&) = delete;
+
+		[[nodiscard]] const uint8_t* data() const;
+
+		[[nodiscard]] size_t size() const;
+};
\ No newline at end of file
@@ -0,0 +1,254 @@
+#include "ModuleFileSource.hpp"
+
+#include <Windows.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+
+#include "CorrectCasingPathUtils.hpp"
+#include "StringUtils.hpp"
+
+file_system_module_file_source::file_system_module_file_source(const std::filesystem::path& executable_file_path)
+    : application_directory_(executable_file_path.parent_path())
+{
+    // The Windows loader finds the imports of application directory modules through the current directory
+    SetCurrentDirectory(application_directory_.wstring().c_str());
+}
+
+const std::filesystem::path& file_system_module_file_source::get_application_directory() const
+{
+    return application_directory_;
+}
+
+bool file_system_module_file_source::exists(const std::filesystem::path& file_path) const
+{
+    return is_regular_file(application_directory_ / file_path);
+}
+
+bool file_system_module_file_source::load(const std::filesystem::path& file_path, std::vector<uint8_t>& buffer) const
+{
+    return load_file_to_buffer(application_directory_ / file_path, buffer);
+}
+
+bool file_system_module_file_source::load_imported_module_names(const std::filesystem::path& file_path,
+                                                                std::set<std::string>& module_names) const
+{
+    std::vector<uint8_t> buffer;
+    return load(file_path, buffer) && get_imported_module_names(buffer, module_names);
+}
+
+std::filesystem::path file_system_module_file_source::find_in_application_directory(const std::filesystem::path& module_name) const
+{
+    if (const auto module_file_path = (application_directory_ / module_name).lexically_normal();
+        is_regular_file(module_file_path))
+    {
+        return correct_path_casing(module_file_path);
+    }
+
+    return "";
+}
+
+bool file_system_module_file_source::is_loadable(const std::filesystem::path& module_file_path) const
+{
+    return !get_loaded_module_file_path(module_file_path).empty();
+}
+
+zip_archive_module_file_source::zip_archive_module_file_source(const std::filesystem::path& archive_file_path,
+                                                               const std::filesystem::path& executable_file_path)
+    : archive_file_path_(archive_file_path), application_directory_(executable_file_path.parent_path()),
+      archive_(archive_file_path)
+{
+}
+
+const zip_archive_entry* zip_archive_module_file_source::find_entry(const std::filesystem::path& file_path) const
+{
+    const auto archive_prefix = archive_file_path_.wstring() + L"\\";
+    const auto normalized_file_path = (application_directory_ / file_path).lexically_normal().wstring();
+    if (!boost::istarts_with(normalized_file_path, archive_prefix))
+    {
+        return nullptr;
+    }
+
+    return archive_.find_entry(wide_string_to_string(normalized_file_path.substr(archive_prefix.size())));
+}
+
+const std::filesystem::path& zip_archive_module_file_source::get_application_directory() const
+{
+    return application_directory_;
+}
+
+bool zip_archive_module_file_source::exists(const std::filesystem::path& file_path) const
+{
+    return find_entry(file_path) != nullptr;
+}
+
+bool zip_archive_module_file_source::load(const std::filesystem::path& file_path, std::vector<uint8_t>& buffer) const
+{
+    const auto entry = find_entry(file_path);
+    if (entry == nullptr)
+    {
+        spdlog::error("Failed to find archive entry: " + wide_string_to_string(file_path.wstring()));
+        return false;
+    }
+
+    spdlog::debug("Decompressing archive entry " + entry->name + "...");
+    return archive_.load_entry_to_buffer(*entry, buffer);
+}
+
+bool zip_archive_module_file_source::load_imported_module_names(const std::filesystem::path& file_path,
+                                                                std::set<std::string>& module_names) const
+{
+    const auto module = load_module(file_path);
+    if (module == nullptr || !module->imports_parsed)
+    {
+        return false;
+    }
+
+    module_names = module->imported_module_names;
+    return true;
+}
+
+std::filesystem::path zip_archive_module_file_source::find_in_application_directory(const std::filesystem::path& module_name) const
+{
+    if (const auto entry = find_entry(module_name);
+        entry != nullptr)
+    {
+        // Use the casing stored in the archive just like the file system would
+        return (archive_file_path_ / string_to_wide_string(entry->name)).make_preferred();
+    }
+
+    return "";
+}
+
+bool zip_archive_module_file_source::is_loadable(const std::filesystem::path& module_file_path) const
+{
+    std::set<std::filesystem::path> visited_module_file_paths;
+    const auto loadable = is_loadable(module_file_path, visited_module_file_paths);
+    loadable_modules_.emplace(module_file_path, loadable);
+    return loadable;
+}
+
+const zip_archive_module* zip_archive_module_file_source::load_module(const std::filesystem::path& module_file_path) const
+{
+    const auto entry = find_entry(module_file_path);
+    if (entry == nullptr)
+    {
+        spdlog::error("Failed to find archive entry: " + wide_string_to_string(module_file_path.wstring()));
+        return nullptr;
+    }
+
+    if (const auto parsed_module = parsed_modules_.find(entry);
+        parsed_module != parsed_modules_.end())
+    {
+        return &parsed_module->second;
+    }
+
+    // Failures are cached as well so broken entries are not decompressed again
+    zip_archive_module module;
+    if (std::vector<uint8_t> buffer;
+        load(module_file_path, buffer))
+    {
+        module.imports_parsed = get_imported_module_names(buffer, module.imported_module_names);
+        module.image_info_read = module.imports_parsed && read_pe_image_info(buffer, module.image_info);
+    }
+
+    return &parsed_modules_.emplace(entry, std::move(module)).first->second;
+}
+
+std::filesystem::path zip_archive_module_file_source::find_system_module_file_path(const std::string& module_name)
+{
+    if (auto system_module_file_path = get_loaded_module_file_path(string_to_wide_string(module_name), LOAD_LIBRARY_SEARCH_SYSTEM32);
+        !system_module_file_path.empty()
+        && boost::istarts_with(system_module_file_path.wstring(), get_windows_directory().wstring()))
+    {
+        return system_module_file_path;
+    }
+
+    return "";
+}
+
+bool zip_archive_module_file_source::is_loadable(const std::filesystem::path& module_file_path,
+                                                 std::set<std::filesystem::path>& visited_module_file_paths) const
+{
+    if (const auto loadable_module = loadable_modules_.find(module_file_path);
+        loadable_module != loadable_modules_.end())
+    {
+        return loadable_module->second;
+    }
+
+    // Import cycles do not prevent loading
+    if (!visited_module_file_paths.insert(module_file_path).second)
+    {
+        return true;
+    }
+
+    // Archive entries cannot be passed to the Windows loader so emulate it.
+    // It rejects images built for another machine type and images which are no DLLs.
+    const auto module = load_module(module_file_path);
+    auto loadable = module != nullptr && module->image_info_read
+        && module->image_info.machine == get_process_machine()
+        && (module->image_info.characteristics & IMAGE_FILE_DLL) != 0;
+    if (!loadable)
+    {
+        loadable_modules_.emplace(module_file_path, loadable);
+        return loadable;
+    }
+
+    for (const auto& imported_module_name : module->imported_module_names)
+    {
+        if (!loadable)
+        {
+            break;
+        }
+
+        // System modules first, then the application directory, every imported symbol must be exported
+        static const std::vector<pe_image_symbol> no_imported_symbols;
+        const auto imported_symbols_entry = module->image_info.imported_symbols.find(boost::algorithm::to_lower_copy(imported_module_name));
+        const auto& imported_symbols = imported_symbols_entry != module->image_info.imported_symbols.end()
+            ? imported_symbols_entry->second : no_imported_symbols;
+
+        if (const auto system_module_file_path = find_system_module_file_path(imported_module_name);
+            !system_module_file_path.empty())
+        {
+            // The module is loaded into this process now so ask the loader itself
+            loadable = std::ranges::all_of(imported_symbols, [&](const pe_image_symbol& imported_symbol)
+            {
+                return is_symbol_exported(system_module_file_path, imported_symbol);
+            });
+            continue;
+        }
+
+        const auto application_module_file_path = find_in_application_directory(string_to_wide_string(imported_module_name));
+        loadable = !application_module_file_path.empty()
+            && is_loadable(application_module_file_path, visited_module_file_paths)
+            && std::ranges::all_of(imported_symbols, [&](const pe_image_symbol& imported_symbol)
+            {
+                return is_symbol_exported(load_module(application_module_file_path)->image_info, imported_symbol);
+            });
+    }
+
+    // Modules inside an import cycle were only found loadable by assuming so, only the outermost result is final
+    if (!loadable)
+    {
+        loadable_modules_.emplace(module_file_path, loadable);
+    }
+    return loadable;
+}
+
+std::unique_ptr<module_file_source> open_module_file_source(const std::filesystem::path& executable_file_path)
+{
+    for (auto parent_file_path = executable_file_path.parent_path();
+        !parent_file_path.empty() && parent_file_path != parent_file_path.root_path();
+        parent_file_path = parent_file_path.parent_path())
+    {
+        if (boost::iequals(parent_file_path.extension().wstring(), L".zip")
+            && is_regular_file(parent_file_path))
+        {
+            spdlog::info("Reading archive " + wide_string_to_string(parent_file_path.wstring()) + "...");
+            return std::make_unique<zip_archive_module_file_source>(parent_file_path, executable_file_path);
+        }
+    }
+
+    return std::make_unique<file_system_module_file_source>(executable_file_path);
+}
\ No newline at end of file
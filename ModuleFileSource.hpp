@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "PEFileUtils.hpp"
+#include "ZipArchive.hpp"
+
+/*
+	Where the analyzed executable and its application directory modules are read from.
+	System modules are always read from the file system.
+*/
+class module_file_source
+{
+	public:
+		virtual ~module_file_source() = default;
+
+		[[nodiscard]] virtual const std::filesystem::path& get_application_directory() const = 0;
+
+		[[nodiscard]] virtual bool exists(const std::filesystem::path& file_path) const = 0;
+
+		// Relative file paths are relative to the application directory
+		virtual bool load(const std::filesystem::path& file_path, std::vector<uint8_t>& buffer) const = 0;
+
+		virtual bool load_imported_module_names(const std::filesystem::path& file_path, std::set<std::string>& module_names) const = 0;
+
+		// Returns the file path of the module in the application directory or an empty path
+		[[nodiscard]] virtual std::filesystem::path find_in_application_directory(const std::filesystem::path& module_name) const = 0;
+
+		// Whether the Windows loader would succeed loading the application directory module including its imports
+		[[nodiscard]] virtual bool is_loadable(const std::filesystem::path& module_file_path) const = 0;
+};
+
+class file_system_module_file_source final : public module_file_source
+{
+	std::filesystem::path application_directory_;
+
+	public:
+		explicit file_system_module_file_source(const std::filesystem::path& executable_file_path);
+
+		[[nodiscard]] const std::filesystem::path& get_application_directory() const override;
+
+		[[nodiscard]] bool exists(const std::filesystem::path& file_path) const override;
+
+		bool load(const std::filesystem::path& file_path, std::vector<uint8_t>& buffer) const override;
+
+		bool load_imported_module_names(const std::filesystem::path& file_path, std::set<std::string>& module_names) const override;
+
+		[[nodiscard]] std::filesystem::path find_in_application_directory(const std::filesystem::path& module_name) const override;
+
+		[[nodiscard]] bool is_loadable(const std::filesystem::path& module_file_path) const override;
+};
+
+class zip_archive_module
+{
+	public:
+		bool imports_parsed = false;
+
+		bool image_info_read = false;
+
+		std::set<std::string> imported_module_names;
+
+		pe_image_info image_info;
+};
+
+/*
+	Treats a directory inside a ZIP archive as the application directory.
+	Entries are only decompressed once they are actually loaded.
+*/
+class zip_archive_module_file_source final : public module_file_source
+{
+	std::filesystem::path archive_file_path_;
+
+	std::filesystem::path application_directory_;
+
+	zip_archive archive_;
+
+	mutable std::map<std::filesystem::path, bool> loadable_modules_;
+
+	// Each entry is only decompressed and parsed once no matter how many modules import it
+	mutable std::unordered_map<const zip_archive_entry*, zip_archive_module> parsed_modules_;
+
+	[[nodiscard]] const zip_archive_entry* find_entry(const std::filesystem::path& file_path) const;
+
+	// Returns nullptr if the entry does not exist
+	[[nodiscard]] const zip_archive_module* load_module(const std::filesystem::path& module_file_path) const;
+
+	// Returns the file path the Windows loader resolves the module name to inside the Windows directory or an empty path
+	[[nodiscard]] static std::filesystem::path find_system_module_file_path(const std::string& module_name);
+
+	[[nodiscard]] bool is_loadable(const std::filesystem::path& module_file_path,
+		std::set<std::filesystem::path>& visited_module_file_paths) const;
+
+	public:
+		zip_archive_module_file_source(const std::filesystem::path& archive_file_path, const std::filesystem::path& executable_file_path);
+
+		[[nodiscard]] const std::filesystem::path& get_application_directory() const override;
+
+		[[nodiscard]] bool exists(const std::filesystem::path& file_path) const override;
+
+		bool load(const std::filesystem::path& file_path, std::vector<uint8_t>& buffer) const override;
+
+		bool load_imported_module_names(const std::filesystem::path& file_path, std::set<std::string>& module_names) const override;
+
+		[[nodiscard]] std::filesystem::path find_in_application_directory(const std::filesystem::path& module_name) const override;
+
+		[[nodiscard]] bool is_loadable(const std::filesystem::path& module_file_path) const override;
+};
+
+/*
+	Picks the ZIP archive source if a parent of the (absolute and normalized) executable file path is a ZIP archive.
+*/
+std::unique_ptr<module_file_source> open_module_file_source(const std::filesystem::path& executable_file_path);
\ No newline at end of file
@@ -0,0 +1,399 @@
+#include "PEFileUtils.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <pe-parse/parse.h>
+#include <spdlog/spdlog.h>
+#include <Windows.h>
+#include <boost/algorithm/string/case_conv.hpp>
+
+#include "StringUtils.hpp"
+
+using parsed_pe_ref = std::unique_ptr<peparse::parsed_pe, void (*)(peparse::parsed_pe*)>;
+
+bool load_file_to_buffer(const std::filesystem::path& file_path, std::vector<uint8_t>& buffer)
+{
+    // Open the file in binary mode
+    std::ifstream file(file_path, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        spdlog::error("Failed to open file: " + wide_string_to_string(file_path.wstring()));
+        return false;
+    }
+
+    // Get the file size
+    const std::ifstream::pos_type file_size = file.tellg();
+    if (file_size <= 0)
+    {
+        spdlog::error("File is empty or error in determining file size: " + wide_string_to_string(file_path.wstring()));
+        return false;
+    }
+
+    // Resize the buffer to fit the file content
+    buffer.resize(file_size);
+
+    // Seek to the beginning and read the file into the buffer
+    file.seekg(0, std::ios::beg);
+    file.read(reinterpret_cast<char*>(buffer.data()), static_cast<long long>(buffer.size()));
+
+    // Check if the read operation was successful
+    if (!file)
+    {
+        spdlog::error("Failed to read file: " + wide_string_to_string(file_path.wstring()));
+        buffer.clear();
+        return false;
+    }
+
+    return true;
+}
+
+// ReSharper disable once CppParameterMayBeConstPtrOrRef
+inline auto dump_module_names(void* output_buffer, const peparse::VA& virtual_address,
+                              const std::string& module_name, const std::string& symbol_name)
+{
+    (void)virtual_address;
+    (void)symbol_name;
+
+    static_cast<std::set<std::string>*>(output_buffer)->insert(module_name);
+
+    // Continue iterating
+    return 0;
+}
+
+bool get_imported_module_names(const std::vector<uint8_t>& buffer, std::set<std::string>& module_names)
+{
+    // The parsed PE references the buffer without copying so it must not outlive it
+    const parsed_pe_ref parsed_pe{
+        peparse::ParsePEFromPointer(const_cast<uint8_t*>(buffer.data()), static_cast<uint32_t>(buffer.size())),
+        peparse::DestructParsedPE
+    };
+    if (!parsed_pe)
+    {
+        return false;
+    }
+
+    IterImpVAString(parsed_pe.get(), &dump_module_names, &module_names);
+    return true;
+}
+
+std::filesystem::path get_windows_directory()
+{
+    wchar_t file_path[MAX_PATH];
+    if (const auto length_copied = GetWindowsDirectory(file_path, MAX_PATH);
+        length_copied == 0)
+    {
+        throw std::runtime_error("GetWindowsDirectory() failed");
+    }
+    return file_path;
+}
+
+std::filesystem::path get_system_directory()
+{
+    wchar_t file_path[MAX_PATH];
+    if (const auto length_copied = GetSystemDirectory(file_path, MAX_PATH);
+        length_copied == 0)
+    {
+        throw std::runtime_error("GetSystemDirectory() failed");
+    }
+    return file_path;
+}
+
+std::filesystem::path get_loaded_module_file_path(const std::filesystem::path& module_name, const uint32_t load_flags)
+{
+    if (const auto module_handle = LoadLibraryEx(module_name.wstring().c_str(), nullptr, load_flags);
+        module_handle != nullptr)
+    {
+        wchar_t module_file_path[MAX_PATH];
+        GetModuleFileName(module_handle, module_file_path, MAX_PATH);
+
+        // Freeing the library is expensive so don't do it
+        /* if (const auto freeing_succeeded = FreeLibrary(module_handle);
+            !freeing_succeeded)
+        {
+            std::cerr << "FreeLibrary() failed on " << module_name << "..." << std::endl;
+        } */
+
+        return module_file_path;
+    }
+
+    return "";
+}
+
+std::filesystem::path find_module_file_path(const std::filesystem::path& module_name)
+{
+    // The module is only mapped so DllMain() never runs, API set names are still redirected to their host modules.
+    // Search the system directories only just like dll_references_resolver does.
+    if (const auto module_handle = LoadLibraryEx(module_name.wstring().c_str(), nullptr,
+        DONT_RESOLVE_DLL_REFERENCES | LOAD_LIBRARY_SEARCH_SYSTEM32);
+        module_handle != nullptr)
+    {
+        wchar_t module_file_path[MAX_PATH];
+        GetModuleFileName(module_handle, module_file_path, MAX_PATH);
+
+        // Unload it again so later regular loads of the module in this process initialize it properly
+        FreeLibrary(module_handle);
+
+        return module_file_path;
+    }
+
+    return "";
+}
+
+constexpr uint32_t pe_signature = 0x00004550;
+constexpr uint16_t pe32_magic = 0x10B;
+constexpr uint16_t pe32_plus_magic = 0x20B;
+constexpr size_t file_header_size = 20;
+constexpr size_t section_header_size = 40;
+constexpr size_t import_descriptor_size = 20;
+constexpr uint32_t export_directory_index = 0;
+constexpr uint32_t import_directory_index = 1;
+
+template <typename T>
+T read_image_value(const std::vector<uint8_t>& buffer, const uint64_t offset)
+{
+    if (offset > buffer.size() || sizeof(T) > buffer.size() - offset)
+    {
+        throw std::runtime_error("The PE file is truncated or corrupted");
+    }
+
+    T value;
+    std::memcpy(&value, buffer.data() + offset, sizeof(T));
+    return value;
+}
+
+class pe_image_sections
+{
+    const std::vector<uint8_t>& buffer_;
+
+    uint64_t section_headers_offset_;
+
+    uint16_t section_count_;
+
+    uint32_t headers_size_;
+
+    public:
+        pe_image_sections(const std::vector<uint8_t>& buffer, const uint64_t section_headers_offset,
+                          const uint16_t section_count, const uint32_t headers_size)
+            : buffer_(buffer), section_headers_offset_(section_headers_offset), section_count_(section_count),
+              headers_size_(headers_size)
+        {
+        }
+
+        [[nodiscard]] uint64_t to_file_offset(const uint32_t relative_virtual_address) const
+        {
+            if (relative_virtual_address < headers_size_)
+            {
+                return relative_virtual_address;
+            }
+
+            for (uint16_t section_index = 0; section_index < section_count_; section_index++)
+            {
+                const auto section_header_offset = section_headers_offset_ + section_index * section_header_size;
+                const auto virtual_size = read_image_value<uint32_t>(buffer_, section_header_offset + 8);
+                const auto virtual_address = read_image_value<uint32_t>(buffer_, section_header_offset + 12);
+                const auto raw_data_size = read_image_value<uint32_t>(buffer_, section_header_offset + 16);
+                const auto raw_data_offset = read_image_value<uint32_t>(buffer_, section_header_offset + 20);
+                if (relative_virtual_address >= virtual_address
+                    && relative_virtual_address - virtual_address < std::max(virtual_size, raw_data_size))
+                {
+                    return static_cast<uint64_t>(raw_data_offset) + (relative_virtual_address - virtual_address);
+                }
+            }
+
+            throw std::runtime_error("The PE file references data outside of its sections");
+        }
+
+        [[nodiscard]] std::string read_string(const uint32_t relative_virtual_address) const
+        {
+            const auto string_offset = to_file_offset(relative_virtual_address);
+            if (string_offset >= buffer_.size())
+            {
+                throw std::runtime_error("The PE file is truncated or corrupted");
+            }
+
+            const auto string_begin = buffer_.begin() + static_cast<std::ptrdiff_t>(string_offset);
+            const auto string_end = std::find(string_begin, buffer_.end(), 0);
+            if (string_end == buffer_.end())
+            {
+                throw std::runtime_error("The PE file is truncated or corrupted");
+            }
+            return { string_begin, string_end };
+        }
+};
+
+inline void read_imported_symbols(const std::vector<uint8_t>& buffer, const pe_image_sections& sections,
+                                  const uint32_t import_directory_address, const bool is_pe32_plus, pe_image_info& image_info)
+{
+    const auto thunk_size = is_pe32_plus ? sizeof(uint64_t) : sizeof(uint32_t);
+    const auto ordinal_flag = is_pe32_plus ? 1ULL << 63 : 1ULL << 31;
+    for (auto descriptor_offset = sections.to_file_offset(import_directory_address);;
+        descriptor_offset += import_descriptor_size)
+    {
+        const auto lookup_table_address = read_image_value<uint32_t>(buffer, descriptor_offset);
+        const auto name_address = read_image_value<uint32_t>(buffer, descriptor_offset + 12);
+        const auto address_table_address = read_image_value<uint32_t>(buffer, descriptor_offset + 16);
+        if (name_address == 0 && address_table_address == 0)
+        {
+            break;
+        }
+
+        auto& symbols = image_info.imported_symbols[boost::algorithm::to_lower_copy(sections.read_string(name_address))];
+
+        // Bound imports overwrite the address table so prefer the lookup table
+        const auto thunk_address = lookup_table_address != 0 ? lookup_table_address : address_table_address;
+        for (auto thunk_offset = sections.to_file_offset(thunk_address);; thunk_offset += thunk_size)
+        {
+            const auto thunk = is_pe32_plus
+                ? read_image_value<uint64_t>(buffer, thunk_offset)
+                : read_image_value<uint32_t>(buffer, thunk_offset);
+            if (thunk == 0)
+            {
+                break;
+            }
+
+            pe_image_symbol symbol;
+            if ((thunk & ordinal_flag) != 0)
+            {
+                symbol.ordinal = static_cast<uint16_t>(thunk);
+            }
+            else
+            {
+                // Skip the hint in front of the name
+                symbol.name = sections.read_string(static_cast<uint32_t>(thunk) + 2);
+            }
+            symbols.push_back(std::move(symbol));
+        }
+    }
+}
+
+inline void read_exported_symbols(const std::vector<uint8_t>& buffer, const pe_image_sections& sections,
+                                  const uint32_t export_directory_address, pe_image_info& image_info)
+{
+    const auto export_directory_offset = sections.to_file_offset(export_directory_address);
+    const auto ordinal_base = read_image_value<uint32_t>(buffer, export_directory_offset + 16);
+    const auto function_count = read_image_value<uint32_t>(buffer, export_directory_offset + 20);
+    const auto name_count = read_image_value<uint32_t>(buffer, export_directory_offset + 24);
+    const auto functions_address = read_image_value<uint32_t>(buffer, export_directory_offset + 28);
+    const auto names_address = read_image_value<uint32_t>(buffer, export_directory_offset + 32);
+
+    if (function_count > 0)
+    {
+        const auto functions_offset = sections.to_file_offset(functions_address);
+        for (uint32_t function_index = 0; function_index < function_count; function_index++)
+        {
+            // Unused slots of the address table are zero
+            if (read_image_value<uint32_t>(buffer, functions_offset + function_index * sizeof(uint32_t)) != 0)
+            {
+                image_info.exported_ordinals.insert(static_cast<uint16_t>(ordinal_base + function_index));
+            }
+        }
+    }
+
+    if (name_count > 0)
+    {
+        const auto names_offset = sections.to_file_offset(names_address);
+        for (uint32_t name_index = 0; name_index < name_count; name_index++)
+        {
+            image_info.exported_names.insert(
+                sections.read_string(read_image_value<uint32_t>(buffer, names_offset + name_index * sizeof(uint32_t))));
+        }
+    }
+}
+
+bool read_pe_image_info(const std::vector<uint8_t>& buffer, pe_image_info& image_info)
+{
+    image_info = {};
+
+    try
+    {
+        const auto nt_headers_offset = read_image_value<uint32_t>(buffer, 0x3C);
+        if (read_image_value<uint16_t>(buffer, 0) != IMAGE_DOS_SIGNATURE
+            || read_image_value<uint32_t>(buffer, nt_headers_offset) != pe_signature)
+        {
+            spdlog::error("The file is not a PE file");
+            return false;
+        }
+
+        const auto file_header_offset = static_cast<uint64_t>(nt_headers_offset) + sizeof(uint32_t);
+        image_info.machine = read_image_value<uint16_t>(buffer, file_header_offset);
+        const auto section_count = read_image_value<uint16_t>(buffer, file_header_offset + 2);
+        const auto optional_header_size = read_image_value<uint16_t>(buffer, file_header_offset + 16);
+        image_info.characteristics = read_image_value<uint16_t>(buffer, file_header_offset + 18);
+
+        const auto optional_header_offset = file_header_offset + file_header_size;
+        const auto optional_header_magic = read_image_value<uint16_t>(buffer, optional_header_offset);
+        if (optional_header_magic != pe32_magic && optional_header_magic != pe32_plus_magic)
+        {
+            spdlog::error("The PE file has an unknown optional header");
+            return false;
+        }
+
+        // The data directories follow the fields which differ in size between PE32 and PE32+
+        const auto is_pe32_plus = optional_header_magic == pe32_plus_magic;
+        const auto data_directory_count = read_image_value<uint32_t>(buffer, optional_header_offset + (is_pe32_plus ? 108 : 92));
+        const auto data_directories_offset = optional_header_offset + (is_pe32_plus ? 112 : 96);
+        const pe_image_sections sections(buffer, optional_header_offset + optional_header_size, section_count,
+            read_image_value<uint32_t>(buffer, optional_header_offset + 60));
+
+        const auto read_data_directory_address = [&](const uint32_t data_directory_index) -> uint32_t
+        {
+            if (data_directory_index >= data_directory_count)
+            {
+                return 0;
+            }
+            return read_image_value<uint32_t>(buffer, data_directories_offset + data_directory_index * 8ULL);
+        };
+
+        if (const auto import_directory_address = read_data_directory_address(import_directory_index);
+            import_directory_address != 0)
+        {
+            read_imported_symbols(buffer, sections, import_directory_address, is_pe32_plus, image_info);
+        }
+
+        if (const auto export_directory_address = read_data_directory_address(export_directory_index);
+            export_directory_address != 0)
+        {
+            read_exported_symbols(buffer, sections, export_directory_address, image_info);
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        spdlog::error(exception.what());
+        return false;
+    }
+
+    return true;
+}
+
+bool is_symbol_exported(const pe_image_info& image_info, const pe_image_symbol& symbol)
+{
+    return symbol.name.empty()
+        ? image_info.exported_ordinals.contains(symbol.ordinal)
+        : image_info.exported_names.contains(symbol.name);
+}
+
+bool is_symbol_exported(const std::filesystem::path& loaded_module_file_path, const pe_image_symbol& symbol)
+{
+    const auto module_handle = GetModuleHandle(loaded_module_file_path.wstring().c_str());
+    if (module_handle == nullptr)
+    {
+        return false;
+    }
+
+    return symbol.name.empty()
+        ? GetProcAddress(module_handle, MAKEINTRESOURCEA(symbol.ordinal)) != nullptr
+        : GetProcAddress(module_handle, symbol.name.c_str()) != nullptr;
+}
+
+uint16_t get_process_machine()
+{
+#if defined(_M_ARM64)
+    return IMAGE_FILE_MACHINE_ARM64;
+#elif defined(_M_X64)
+    return IMAGE_FILE_MACHINE_AMD64;
+#else
+    return IMAGE_FILE_MACHINE_I386;
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+bool load_file_to_buffer(const std::filesystem::path& file_path, std::vector<uint8_t>& buffer);
+
+bool get_imported_module_names(const std::vector<uint8_t>& buffer, std::set<std::string>& module_names);
+
+class pe_image_symbol
+{
+	public:
+		// Empty if the symbol is imported by ordinal
+		std::string name;
+
+		uint16_t ordinal = 0;
+};
+
+// The parts of a PE image the Windows loader validates when loading it as a DLL
+class pe_image_info
+{
+	public:
+		uint16_t machine = 0;
+
+		uint16_t characteristics = 0;
+
+		// Keyed by the lower-cased imported module name
+		std::map<std::string, std::vector<pe_image_symbol>> imported_symbols;
+
+		std::set<std::string> exported_names;
+
+		std::set<uint16_t> exported_ordinals;
+};
+
+/*
+    Reads the headers, the import and the export directory straight from the file contents.
+    Delay-loaded imports are not included since the loader only resolves them on first use.
+*/
+bool read_pe_image_info(const std::vector<uint8_t>& buffer, pe_image_info& image_info);
+
+[[nodiscard]] bool is_symbol_exported(const pe_image_info& image_info, const pe_image_symbol& symbol);
+
+// Whether the already loaded module exports the symbol, forwarded exports are followed
+[[nodiscard]] bool is_symbol_exported(const std::filesystem::path& loaded_module_file_path, const pe_image_symbol& symbol);
+
+// The machine type of DLLs this process can load
+uint16_t get_process_machine();
+
+std::filesystem::path get_windows_directory();
+
+std::filesystem::path get_system_directory();
+
+/*
+    Returns the file path the Windows loader resolves the module name to or an empty path.
+    The module stays loaded, the load flags are passed to LoadLibraryEx().
+*/
+std::filesystem::path get_loaded_module_file_path(const std::filesystem::path& module_name, uint32_t load_flags = 0);
+
+/*
+    Like get_loaded_module_file_path() with LOAD_LIBRARY_SEARCH_SYSTEM32 but neither runs any module code nor loads the dependencies.
+    The module is unloaded again afterwards.
+*/
+std::filesystem::path find_module_file_path(const std::filesystem::path& module_name);
\ No newline at end of file
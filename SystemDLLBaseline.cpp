@@ -0,0 +1,514 @@
+#include "SystemDLLBaseline.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <ranges>
+#include <unordered_map>
+#include <Windows.h>
+#include <spdlog/spdlog.h>
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+
+#include "CorrectCasingPathUtils.hpp"
+#include "ExecutionTimer.hpp"
+#include "PEFileUtils.hpp"
+#include "StringUtils.hpp"
+
+/*
+    Snapshot file layout, all offsets are relative to the beginning of the file:
+    header | module entries | import entries | string entries | string data
+    Module entries are sorted by their lower-cased file path so lookups are a binary search.
+*/
+constexpr char baseline_magic[8] = { 'D', 'L', 'L', 'B', 'A', 'S', 'E', '\0' };
+constexpr uint32_t baseline_version = 1;
+constexpr uint32_t no_index = UINT32_MAX;
+constexpr uint32_t module_flag_loadable = 1;
+
+struct system_dll_baseline_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t system_directory_string;
+    uint32_t module_count;
+    uint32_t import_count;
+    uint32_t string_count;
+    uint32_t string_data_size;
+    uint64_t module_entries_offset;
+    uint64_t import_entries_offset;
+    uint64_t string_entries_offset;
+    uint64_t string_data_offset;
+};
+
+struct system_dll_baseline_module_entry
+{
+    uint32_t key_string;
+    uint32_t file_path_string;
+    uint64_t file_size;
+    uint64_t last_write_time;
+    uint32_t first_import;
+    uint32_t import_count;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+struct system_dll_baseline_import_entry
+{
+    uint32_t module_name_string;
+    uint32_t resolved_file_path_string;
+    uint32_t module_index;
+    uint32_t reserved;
+};
+
+struct system_dll_baseline_string_entry
+{
+    uint32_t offset;
+    uint32_t length;
+};
+
+static_assert(sizeof(system_dll_baseline_header) == 64);
+static_assert(sizeof(system_dll_baseline_module_entry) == 40);
+static_assert(sizeof(system_dll_baseline_import_entry) == 16);
+static_assert(sizeof(system_dll_baseline_string_entry) == 8);
+
+class file_identity_stamp
+{
+    public:
+        uint64_t file_size = 0;
+
+        uint64_t last_write_time = 0;
+};
+
+inline bool read_file_identity_stamp(const std::filesystem::path& file_path, file_identity_stamp& stamp)
+{
+    WIN32_FILE_ATTRIBUTE_DATA attribute_data{};
+    if (!GetFileAttributesEx(file_path.wstring().c_str(), GetFileExInfoStandard, &attribute_data))
+    {
+        return false;
+    }
+
+    stamp.file_size = static_cast<uint64_t>(attribute_data.nFileSizeHigh) << 32 | attribute_data.nFileSizeLow;
+    stamp.last_write_time = static_cast<uint64_t>(attribute_data.ftLastWriteTime.dwHighDateTime) << 32
+        | attribute_data.ftLastWriteTime.dwLowDateTime;
+    return true;
+}
+
+inline std::string build_module_key(const std::filesystem::path& module_file_path)
+{
+    return wide_string_to_string(boost::algorithm::to_lower_copy(module_file_path.lexically_normal().wstring()));
+}
+
+[[noreturn]] inline void throw_corrupted_baseline()
+{
+    throw std::runtime_error("The baseline snapshot is corrupted");
+}
+
+inline bool is_region_valid(const uint64_t offset, const uint64_t count, const uint64_t entry_size, const uint64_t file_size)
+{
+    return offset <= file_size && count <= (file_size - offset) / entry_size;
+}
+
+system_dll_baseline::system_dll_baseline(const std::filesystem::path& snapshot_file_path)
+    : snapshot_file_(snapshot_file_path)
+{
+    const auto data = snapshot_file_.data();
+    const auto size = snapshot_file_.size();
+    if (size < sizeof(system_dll_baseline_header))
+    {
+        throw_corrupted_baseline();
+    }
+
+    header_ = reinterpret_cast<const system_dll_baseline_header*>(data);
+    if (std::memcmp(header_->magic, baseline_magic, sizeof baseline_magic) != 0)
+    {
+        throw std::runtime_error(wide_string_to_string(snapshot_file_path.wstring()) + " is not a baseline snapshot");
+    }
+
+    if (header_->version != baseline_version)
+    {
+        throw std::runtime_error("Unsupported baseline snapshot version " + std::to_string(header_->version)
+            + ", rebuild it with --build-baseline");
+    }
+
+    if (!is_region_valid(header_->module_entries_offset, header_->module_count, sizeof(system_dll_baseline_module_entry), size)
+        || !is_region_valid(header_->import_entries_offset, header_->import_count, sizeof(system_dll_baseline_import_entry), size)
+        || !is_region_valid(header_->string_entries_offset, header_->string_count, sizeof(system_dll_baseline_string_entry), size)
+        || !is_region_valid(header_->string_data_offset, header_->string_data_size, 1, size))
+    {
+        throw_corrupted_baseline();
+    }
+
+    module_entries_ = reinterpret_cast<const system_dll_baseline_module_entry*>(data + header_->module_entries_offset);
+    import_entries_ = reinterpret_cast<const system_dll_baseline_import_entry*>(data + header_->import_entries_offset);
+    string_entries_ = reinterpret_cast<const system_dll_baseline_string_entry*>(data + header_->string_entries_offset);
+    string_data_ = reinterpret_cast<const char*>(data + header_->string_data_offset);
+}
+
+std::string_view system_dll_baseline::get_string(const uint32_t string_index) const
+{
+    if (string_index >= header_->string_count)
+    {
+        throw_corrupted_baseline();
+    }
+
+    const auto& [offset, length] = string_entries_[string_index];
+    if (!is_region_valid(offset, length, 1, header_->string_data_size))
+    {
+        throw_corrupted_baseline();
+    }
+
+    return { string_data_ + offset, length };
+}
+
+const system_dll_baseline_module_entry& system_dll_baseline::get_module_entry(const uint32_t module_index) const
+{
+    if (module_index >= header_->module_count)
+    {
+        throw_corrupted_baseline();
+    }
+
+    return module_entries_[module_index];
+}
+
+std::filesystem::path system_dll_baseline::get_system_directory() const
+{
+    return string_to_wide_string(std::string(get_string(header_->system_directory_string)));
+}
+
+uint32_t system_dll_baseline::get_module_count() const
+{
+    return header_->module_count;
+}
+
+std::optional<uint32_t> system_dll_baseline::find_module(const std::filesystem::path& module_file_path) const
+{
+    const auto module_key = build_module_key(module_file_path);
+
+    uint32_t lower_bound = 0;
+    uint32_t upper_bound = header_->module_count;
+    while (lower_bound < upper_bound)
+    {
+        const auto middle = lower_bound + (upper_bound - lower_bound) / 2;
+        const auto comparison = get_string(module_entries_[middle].key_string).compare(module_key);
+        if (comparison == 0)
+        {
+            return middle;
+        }
+
+        if (comparison < 0)
+        {
+            lower_bound = middle + 1;
+        }
+        else
+        {
+            upper_bound = middle;
+        }
+    }
+
+    return std::nullopt;
+}
+
+std::filesystem::path system_dll_baseline::get_module_file_path(const uint32_t module_index) const
+{
+    return string_to_wide_string(std::string(get_string(get_module_entry(module_index).file_path_string)));
+}
+
+bool system_dll_baseline::is_module_loadable(const uint32_t module_index) const
+{
+    return (get_module_entry(module_index).flags & module_flag_loadable) != 0;
+}
+
+bool system_dll_baseline::is_module_up_to_date(const uint32_t module_index) const
+{
+    const auto& module_entry = get_module_entry(module_index);
+    file_identity_stamp stamp;
+    return read_file_identity_stamp(get_module_file_path(module_index), stamp)
+        && stamp.file_size == module_entry.file_size
+        && stamp.last_write_time == module_entry.last_write_time;
+}
+
+std::vector<system_dll_baseline_import> system_dll_baseline::get_module_imports(const uint32_t module_index) const
+{
+    const auto& module_entry = get_module_entry(module_index);
+    if (!is_region_valid(module_entry.first_import, module_entry.import_count, 1, header_->import_count))
+    {
+        throw_corrupted_baseline();
+    }
+
+    std::vector<system_dll_baseline_import> imports;
+    imports.reserve(module_entry.import_count);
+    for (uint32_t import_index = 0; import_index < module_entry.import_count; import_index++)
+    {
+        const auto& import_entry = import_entries_[module_entry.first_import + import_index];
+
+        system_dll_baseline_import module_import;
+        module_import.module_name = string_to_wide_string(std::string(get_string(import_entry.module_name_string)));
+        if (import_entry.resolved_file_path_string != no_index)
+        {
+            module_import.resolved_file_path = string_to_wide_string(std::string(get_string(import_entry.resolved_file_path_string)));
+        }
+        if (import_entry.module_index != no_index)
+        {
+            module_import.module_index = import_entry.module_index;
+        }
+        imports.push_back(module_import);
+    }
+
+    return imports;
+}
+
+class baseline_string_table
+{
+    std::unordered_map<std::string, uint32_t> string_indices_;
+
+    public:
+        std::vector<system_dll_baseline_string_entry> string_entries;
+
+        std::string string_data;
+
+        uint32_t intern(const std::string& string)
+        {
+            if (const auto string_index = string_indices_.find(string);
+                string_index != string_indices_.end())
+            {
+                return string_index->second;
+            }
+
+            const auto string_index = static_cast<uint32_t>(string_entries.size());
+            string_entries.push_back({ static_cast<uint32_t>(string_data.size()), static_cast<uint32_t>(string.size()) });
+            string_data += string;
+            string_indices_.emplace(string, string_index);
+            return string_index;
+        }
+};
+
+class scanned_module
+{
+    public:
+        std::filesystem::path file_path;
+
+        file_identity_stamp stamp;
+
+        // Imported module names with their resolved file paths, empty if unresolved
+        std::vector<std::pair<std::string, std::filesystem::path>> imports;
+
+        bool loadable = false;
+};
+
+inline uint64_t align_offset(const uint64_t offset)
+{
+    return (offset + 7) & ~static_cast<uint64_t>(7);
+}
+
+template <typename T>
+void write_entries(std::ofstream& file_writer, const std::vector<T>& entries, const uint64_t offset)
+{
+    file_writer.seekp(static_cast<std::streamoff>(offset));
+    file_writer.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(T)));
+}
+
+void build_system_dll_baseline(const std::filesystem::path& system_directory, const std::filesystem::path& snapshot_file_path)
+{
+    if (!is_directory(system_directory))
+    {
+        throw std::runtime_error("System directory \"" + wide_string_to_string(system_directory.wstring()) + "\" does not exist");
+    }
+
+    const auto corrected_system_directory = correct_path_casing(absolute(system_directory));
+    const auto windows_directory = get_windows_directory();
+
+    spdlog::info("Building baseline of " + wide_string_to_string(corrected_system_directory.wstring()) + "...");
+    const execution_timer timer;
+
+    std::deque<std::filesystem::path> pending_module_file_paths;
+    for (const auto& directory_entry : std::filesystem::directory_iterator(corrected_system_directory,
+        std::filesystem::directory_options::skip_permission_denied))
+    {
+        if (std::error_code error_code;
+            directory_entry.is_regular_file(error_code)
+            && boost::iequals(directory_entry.path().extension().wstring(), L".dll"))
+        {
+            pending_module_file_paths.push_back(directory_entry.path());
+        }
+    }
+
+    // Also scan modules outside the system directory as long as they are reachable from it
+    std::map<std::string, scanned_module> scanned_modules;
+    std::map<std::string, std::filesystem::path> resolved_module_names;
+    std::vector<uint8_t> buffer;
+    while (!pending_module_file_paths.empty())
+    {
+        const auto module_file_path = pending_module_file_paths.front();
+        pending_module_file_paths.pop_front();
+
+        const auto module_key = build_module_key(module_file_path);
+        if (scanned_modules.contains(module_key))
+        {
+            continue;
+        }
+
+        scanned_module module;
+        module.file_path = module_file_path;
+        if (!read_file_identity_stamp(module_file_path, module.stamp) || !load_file_to_buffer(module_file_path, buffer))
+        {
+            continue;
+        }
+
+        std::set<std::string> imported_module_names;
+        if (!get_imported_module_names(buffer, imported_module_names))
+        {
+            // Leave it to live parsing to report the failure
+            spdlog::debug("Failed parsing PE file " + wide_string_to_string(module_file_path.wstring()) + ", not adding it to the baseline...");
+            continue;
+        }
+
+        for (const auto& imported_module_name : imported_module_names)
+        {
+            const auto module_name_key = boost::algorithm::to_lower_copy(imported_module_name);
+            auto resolved_module_name = resolved_module_names.find(module_name_key);
+            if (resolved_module_name == resolved_module_names.end())
+            {
+                std::filesystem::path resolved_file_path;
+                if (const auto found_module_file_path = find_module_file_path(string_to_wide_string(imported_module_name));
+                    !found_module_file_path.empty()
+                    && boost::istarts_with(found_module_file_path.wstring(), windows_directory.wstring()))
+                {
+                    resolved_file_path = correct_path_casing(found_module_file_path);
+                    pending_module_file_paths.push_back(resolved_file_path);
+                }
+                resolved_module_name = resolved_module_names.emplace(module_name_key, resolved_file_path).first;
+            }
+
+            module.imports.emplace_back(imported_module_name, resolved_module_name->second);
+        }
+
+        scanned_modules.emplace(module_key, std::move(module));
+    }
+
+    // A module is loadable if its name resolved and all of its imports are loadable as well.
+    // Start out optimistic so import cycles do not prevent loading, then remove modules until nothing changes.
+    for (const auto& module : scanned_modules | std::views::values)
+    {
+        for (const auto& resolved_file_path : module.imports | std::views::values)
+        {
+            if (resolved_file_path.empty())
+            {
+                continue;
+            }
+
+            if (const auto resolved_module = scanned_modules.find(build_module_key(resolved_file_path));
+                resolved_module != scanned_modules.end())
+            {
+                resolved_module->second.loadable = true;
+            }
+        }
+    }
+
+    auto loadable_modules_changed = true;
+    while (loadable_modules_changed)
+    {
+        loadable_modules_changed = false;
+        for (auto& module : scanned_modules | std::views::values)
+        {
+            if (!module.loadable)
+            {
+                continue;
+            }
+
+            for (const auto& resolved_file_path : module.imports | std::views::values)
+            {
+                const auto resolved_module = resolved_file_path.empty()
+                    ? scanned_modules.end() : scanned_modules.find(build_module_key(resolved_file_path));
+                if (resolved_module == scanned_modules.end() || !resolved_module->second.loadable)
+                {
+                    module.loadable = false;
+                    loadable_modules_changed = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    // The map is ordered by module key which is exactly the order lookups binary search in
+    std::map<std::string, uint32_t> module_indices;
+    for (const auto& module_key : scanned_modules | std::views::keys)
+    {
+        module_indices.emplace(module_key, static_cast<uint32_t>(module_indices.size()));
+    }
+
+    baseline_string_table string_table;
+    std::vector<system_dll_baseline_module_entry> module_entries;
+    std::vector<system_dll_baseline_import_entry> import_entries;
+    for (const auto& [module_key, module] : scanned_modules)
+    {
+        system_dll_baseline_module_entry module_entry{};
+        module_entry.key_string = string_table.intern(module_key);
+        module_entry.file_path_string = string_table.intern(wide_string_to_string(module.file_path.wstring()));
+        module_entry.file_size = module.stamp.file_size;
+        module_entry.last_write_time = module.stamp.last_write_time;
+        module_entry.first_import = static_cast<uint32_t>(import_entries.size());
+        module_entry.import_count = static_cast<uint32_t>(module.imports.size());
+        module_entry.flags = module.loadable ? module_flag_loadable : 0;
+        module_entries.push_back(module_entry);
+
+        for (const auto& [imported_module_name, resolved_file_path] : module.imports)
+        {
+            system_dll_baseline_import_entry import_entry{};
+            import_entry.module_name_string = string_table.intern(imported_module_name);
+            import_entry.resolved_file_path_string = no_index;
+            import_entry.module_index = no_index;
+            if (!resolved_file_path.empty())
+            {
+                import_entry.resolved_file_path_string = string_table.intern(wide_string_to_string(resolved_file_path.wstring()));
+                if (const auto module_index = module_indices.find(build_module_key(resolved_file_path));
+                    module_index != module_indices.end())
+                {
+                    import_entry.module_index = module_index->second;
+                }
+            }
+            import_entries.push_back(import_entry);
+        }
+    }
+
+    system_dll_baseline_header header{};
+    std::memcpy(header.magic, baseline_magic, sizeof baseline_magic);
+    header.version = baseline_version;
+    header.system_directory_string = string_table.intern(wide_string_to_string(corrected_system_directory.wstring()));
+    header.module_count = static_cast<uint32_t>(module_entries.size());
+    header.import_count = static_cast<uint32_t>(import_entries.size());
+    header.string_count = static_cast<uint32_t>(string_table.string_entries.size());
+    header.string_data_size = static_cast<uint32_t>(string_table.string_data.size());
+    header.module_entries_offset = align_offset(sizeof header);
+    header.import_entries_offset = align_offset(header.module_entries_offset + module_entries.size() * sizeof(system_dll_baseline_module_entry));
+    header.string_entries_offset = align_offset(header.import_entries_offset + import_entries.size() * sizeof(system_dll_baseline_import_entry));
+    header.string_data_offset = align_offset(header.string_entries_offset + string_table.string_entries.size() * sizeof(system_dll_baseline_string_entry));
+
+    // Write to a temporary file first so an existing baseline is never observed half-written
+    auto temporary_file_path = snapshot_file_path;
+    temporary_file_path += L".tmp";
+    {
+        std::ofstream file_writer(temporary_file_path, std::ios::binary | std::ios::trunc);
+        if (file_writer.fail())
+        {
+            throw std::runtime_error("Failed writing to " + wide_string_to_string(temporary_file_path.wstring()));
+        }
+
+        file_writer.write(reinterpret_cast<const char*>(&header), sizeof header);
+        write_entries(file_writer, module_entries, header.module_entries_offset);
+        write_entries(file_writer, import_entries, header.import_entries_offset);
+        write_entries(file_writer, string_table.string_entries, header.string_entries_offset);
+        file_writer.seekp(static_cast<std::streamoff>(header.string_data_offset));
+        file_writer.write(string_table.string_data.data(), static_cast<std::streamsize>(string_table.string_data.size()));
+        if (!file_writer)
+        {
+            throw std::runtime_error("Failed writing to " + wide_string_to_string(temporary_file_path.wstring()));
+        }
+    }
+    std::filesystem::rename(temporary_file_path, snapshot_file_path);
+
+    spdlog::info("Baseline module count: " + std::to_string(module_entries.size())
+        + ", import count: " + std::to_string(import_entries.size()));
+    spdlog::info(timer.build_log_message("Building baseline " + wide_string_to_string(snapshot_file_path.wstring())));
+}
\ No newline at end of file
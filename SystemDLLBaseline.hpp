@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "MemoryMappedFile.hpp"
+
+struct system_dll_baseline_header;
+struct system_dll_baseline_module_entry;
+struct system_dll_baseline_import_entry;
+struct system_dll_baseline_string_entry;
+
+class system_dll_baseline_import
+{
+	public:
+		std::filesystem::path module_name;
+
+		// Empty if the Windows loader could not resolve the module name when the baseline was built
+		std::filesystem::path resolved_file_path;
+
+		// Only set if the resolved module is part of the baseline as well
+		std::optional<uint32_t> module_index;
+};
+
+/*
+	Read-only view on a baseline snapshot file which is memory-mapped as a whole.
+	Nothing is deserialized up front so opening a baseline is cheap regardless of its size.
+*/
+class system_dll_baseline
+{
+	memory_mapped_file snapshot_file_;
+
+	const system_dll_baseline_header* header_ = nullptr;
+
+	const system_dll_baseline_module_entry* module_entries_ = nullptr;
+
+	const system_dll_baseline_import_entry* import_entries_ = nullptr;
+
+	const system_dll_baseline_string_entry* string_entries_ = nullptr;
+
+	const char* string_data_ = nullptr;
+
+	[[nodiscard]] std::string_view get_string(uint32_t string_index) const;
+
+	[[nodiscard]] const system_dll_baseline_module_entry& get_module_entry(uint32_t module_index) const;
+
+	public:
+		explicit system_dll_baseline(const std::filesystem::path& snapshot_file_path);
+
+		[[nodiscard]] std::filesystem::path get_system_directory() const;
+
+		[[nodiscard]] uint32_t get_module_count() const;
+
+		[[nodiscard]] std::optional<uint32_t> find_module(const std::filesystem::path& module_file_path) const;
+
+		[[nodiscard]] std::filesystem::path get_module_file_path(uint32_t module_index) const;
+
+		// Whether an import name resolved to this module and all of its imports were loadable when the baseline was built.
+		// Computed from the import graph, import cycles count as loadable.
+		[[nodiscard]] bool is_module_loadable(uint32_t module_index) const;
+
+		// Whether the module file on disk still matches the stamp recorded in the baseline
+		[[nodiscard]] bool is_module_up_to_date(uint32_t module_index) const;
+
+		[[nodiscard]] std::vector<system_dll_baseline_import> get_module_imports(uint32_t module_index) const;
+};
+
+void build_system_dll_baseline(const std::filesystem::path& system_directory, const std::filesystem::path& snapshot_file_path);
\ No newline at end of file
@@ -0,0 +1,260 @@
+#include "ZipArchive.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <spdlog/spdlog.h>
+#include <boost/algorithm/string/case_conv.hpp>
+#include <zlib.h>
+
+constexpr uint32_t end_of_central_directory_signature = 0x06054B50;
+constexpr uint32_t zip64_end_of_central_directory_locator_signature = 0x07064B50;
+constexpr uint32_t zip64_end_of_central_directory_signature = 0x06064B50;
+constexpr uint32_t central_directory_header_signature = 0x02014B50;
+constexpr uint32_t local_file_header_signature = 0x04034B50;
+constexpr uint16_t zip64_extra_field_id = 0x0001;
+constexpr size_t end_of_central_directory_size = 22;
+constexpr size_t zip64_end_of_central_directory_locator_size = 20;
+constexpr size_t central_directory_header_size = 46;
+constexpr size_t local_file_header_size = 30;
+constexpr uint16_t stored_compression_method = 0;
+constexpr uint16_t deflate_compression_method = 8;
+constexpr uint16_t encrypted_flag = 1;
+
+template <typename T>
+T read_little_endian(const uint8_t* data, const size_t size, const uint64_t offset)
+{
+    if (offset > size || sizeof(T) > size - offset)
+    {
+        throw std::runtime_error("The ZIP archive is truncated or corrupted");
+    }
+
+    // ZIP archives are little endian just like Windows
+    T value;
+    std::memcpy(&value, data + offset, sizeof(T));
+    return value;
+}
+
+inline std::string build_entry_key(const std::string& entry_name)
+{
+    auto entry_key = boost::algorithm::to_lower_copy(entry_name);
+    std::ranges::replace(entry_key, '\\', '/');
+    return entry_key;
+}
+
+zip_archive::zip_archive(const std::filesystem::path& archive_file_path)
+    : archive_file_(archive_file_path)
+{
+    read_central_directory();
+}
+
+void zip_archive::read_central_directory()
+{
+    const auto data = archive_file_.data();
+    const auto size = archive_file_.size();
+    if (size < end_of_central_directory_size)
+    {
+        throw std::runtime_error("The file is too small to be a ZIP archive");
+    }
+
+    // The end of central directory record is followed by a comment of up to 65535 bytes
+    const auto minimum_offset = size > end_of_central_directory_size + UINT16_MAX
+        ? size - end_of_central_directory_size - UINT16_MAX : 0;
+    auto end_of_central_directory_offset = size - end_of_central_directory_size;
+    while (read_little_endian<uint32_t>(data, size, end_of_central_directory_offset) != end_of_central_directory_signature)
+    {
+        if (end_of_central_directory_offset == minimum_offset)
+        {
+            throw std::runtime_error("The end of central directory record of the ZIP archive was not found");
+        }
+        end_of_central_directory_offset--;
+    }
+
+    uint64_t entry_count = read_little_endian<uint16_t>(data, size, end_of_central_directory_offset + 10);
+    uint64_t central_directory_offset = read_little_endian<uint32_t>(data, size, end_of_central_directory_offset + 16);
+    if ((entry_count == UINT16_MAX || central_directory_offset == UINT32_MAX)
+        && end_of_central_directory_offset >= zip64_end_of_central_directory_locator_size)
+    {
+        if (const auto locator_offset = end_of_central_directory_offset - zip64_end_of_central_directory_locator_size;
+            read_little_endian<uint32_t>(data, size, locator_offset) == zip64_end_of_central_directory_locator_signature)
+        {
+            const auto zip64_end_of_central_directory_offset = read_little_endian<uint64_t>(data, size, locator_offset + 8);
+            if (read_little_endian<uint32_t>(data, size, zip64_end_of_central_directory_offset) != zip64_end_of_central_directory_signature)
+            {
+                throw std::runtime_error("The ZIP64 end of central directory record of the ZIP archive is corrupted");
+            }
+
+            entry_count = read_little_endian<uint64_t>(data, size, zip64_end_of_central_directory_offset + 32);
+            central_directory_offset = read_little_endian<uint64_t>(data, size, zip64_end_of_central_directory_offset + 48);
+        }
+    }
+
+    auto entry_offset = central_directory_offset;
+    for (uint64_t entry_index = 0; entry_index < entry_count; entry_index++)
+    {
+        if (read_little_endian<uint32_t>(data, size, entry_offset) != central_directory_header_signature)
+        {
+            throw std::runtime_error("The central directory of the ZIP archive is corrupted");
+        }
+
+        zip_archive_entry entry;
+        entry.flags = read_little_endian<uint16_t>(data, size, entry_offset + 8);
+        entry.compression_method = read_little_endian<uint16_t>(data, size, entry_offset + 10);
+        entry.crc32 = read_little_endian<uint32_t>(data, size, entry_offset + 16);
+        entry.compressed_size = read_little_endian<uint32_t>(data, size, entry_offset + 20);
+        entry.uncompressed_size = read_little_endian<uint32_t>(data, size, entry_offset + 24);
+        const auto name_length = read_little_endian<uint16_t>(data, size, entry_offset + 28);
+        const auto extra_field_length = read_little_endian<uint16_t>(data, size, entry_offset + 30);
+        const auto comment_length = read_little_endian<uint16_t>(data, size, entry_offset + 32);
+        entry.local_header_offset = read_little_endian<uint32_t>(data, size, entry_offset + 42);
+
+        const auto name_offset = entry_offset + central_directory_header_size;
+        if (name_offset + name_length + extra_field_length > size)
+        {
+            throw std::runtime_error("The central directory of the ZIP archive is truncated");
+        }
+        entry.name.assign(reinterpret_cast<const char*>(data + name_offset), name_length);
+
+        // Sizes and offsets which do not fit into 32 bits are moved to the ZIP64 extra field in this order
+        auto extra_field_offset = name_offset + name_length;
+        const auto extra_fields_end = extra_field_offset + extra_field_length;
+        while (extra_field_offset + 4 <= extra_fields_end)
+        {
+            const auto field_id = read_little_endian<uint16_t>(data, size, extra_field_offset);
+            const auto field_length = read_little_endian<uint16_t>(data, size, extra_field_offset + 2);
+            if (field_id == zip64_extra_field_id)
+            {
+                auto value_offset = extra_field_offset + 4;
+                for (auto* value : { &entry.uncompressed_size, &entry.compressed_size, &entry.local_header_offset })
+                {
+                    if (*value == UINT32_MAX && value_offset + 8 <= extra_field_offset + 4 + field_length)
+                    {
+                        *value = read_little_endian<uint64_t>(data, size, value_offset);
+                        value_offset += 8;
+                    }
+                }
+            }
+            extra_field_offset += 4 + field_length;
+        }
+
+        entry_offset = extra_fields_end + comment_length;
+
+        // Directories carry no data
+        if (entry.name.empty() || entry.name.back() == '/' || entry.name.back() == '\\')
+        {
+            continue;
+        }
+
+        entries_.emplace(build_entry_key(entry.name), std::move(entry));
+    }
+}
+
+const zip_archive_entry* zip_archive::find_entry(const std::string& entry_name) const
+{
+    if (const auto entry = entries_.find(build_entry_key(entry_name));
+        entry != entries_.end())
+    {
+        return &entry->second;
+    }
+
+    return nullptr;
+}
+
+bool zip_archive::load_entry_to_buffer(const zip_archive_entry& entry, std::vector<uint8_t>& buffer) const
+{
+    const auto data = archive_file_.data();
+    const auto size = archive_file_.size();
+
+    if ((entry.flags & encrypted_flag) != 0)
+    {
+        spdlog::error("Encrypted ZIP archive entries are not supported: " + entry.name);
+        return false;
+    }
+
+    if (entry.uncompressed_size == 0 || entry.uncompressed_size > UINT32_MAX)
+    {
+        spdlog::error("ZIP archive entry is empty or too large: " + entry.name);
+        return false;
+    }
+
+    // The local header may carry a different extra field than the central directory
+    if (read_little_endian<uint32_t>(data, size, entry.local_header_offset) != local_file_header_signature)
+    {
+        spdlog::error("Local file header of ZIP archive entry is corrupted: " + entry.name);
+        return false;
+    }
+    const auto name_length = read_little_endian<uint16_t>(data, size, entry.local_header_offset + 26);
+    const auto extra_field_length = read_little_endian<uint16_t>(data, size, entry.local_header_offset + 28);
+    const auto compressed_data_offset = entry.local_header_offset + local_file_header_size + name_length + extra_field_length;
+    if (compressed_data_offset > size || entry.compressed_size > size - compressed_data_offset)
+    {
+        spdlog::error("ZIP archive entry is truncated: " + entry.name);
+        return false;
+    }
+    const auto compressed_data = data + compressed_data_offset;
+
+    buffer.resize(entry.uncompressed_size);
+    if (entry.compression_method == stored_compression_method)
+    {
+        if (entry.compressed_size != entry.uncompressed_size)
+        {
+            spdlog::error("Stored ZIP archive entry has an invalid size: " + entry.name);
+            buffer.clear();
+            return false;
+        }
+        std::memcpy(buffer.data(), compressed_data, buffer.size());
+    }
+    else if (entry.compression_method == deflate_compression_method)
+    {
+        z_stream stream{};
+        // Negative window bits select a raw deflate stream without zlib header
+        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+        {
+            spdlog::error("inflateInit2() failed");
+            buffer.clear();
+            return false;
+        }
+
+        // Inflate in chunks since zlib only takes 32-bit lengths
+        auto remaining_input = entry.compressed_size;
+        auto input = compressed_data;
+        stream.next_out = buffer.data();
+        stream.avail_out = static_cast<uInt>(buffer.size());
+        auto inflate_result = Z_OK;
+        while (inflate_result == Z_OK)
+        {
+            if (stream.avail_in == 0 && remaining_input > 0)
+            {
+                const auto chunk_size = static_cast<uInt>(std::min<uint64_t>(remaining_input, UINT32_MAX));
+                stream.next_in = const_cast<Bytef*>(input);
+                stream.avail_in = chunk_size;
+                input += chunk_size;
+                remaining_input -= chunk_size;
+            }
+            inflate_result = inflate(&stream, Z_NO_FLUSH);
+        }
+        inflateEnd(&stream);
+
+        if (inflate_result != Z_STREAM_END || stream.total_out != buffer.size())
+        {
+            spdlog::error("Failed decompressing ZIP archive entry: " + entry.name);
+            buffer.clear();
+            return false;
+        }
+    }
+    else
+    {
+        spdlog::error("Unsupported compression method " + std::to_string(entry.compression_method)
+            + " of ZIP archive entry: " + entry.name);
+        buffer.clear();
+        return false;
+    }
+
+    if (::crc32(0, buffer.data(), static_cast<uInt>(buffer.size())) != entry.crc32)
+    {
+        spdlog::error("CRC32 mismatch of ZIP archive entry: " + entry.name);
+        buffer.clear();
+        return false;
+    }
+
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MemoryMappedFile.hpp"
+
+class zip_archive_entry
+{
+	public:
+		// Relative to the archive root with forward slashes as stored in the archive
+		std::string name;
+
+		uint64_t compressed_size = 0;
+
+		uint64_t uncompressed_size = 0;
+
+		uint64_t local_header_offset = 0;
+
+		uint32_t crc32 = 0;
+
+		uint16_t compression_method = 0;
+
+		uint16_t flags = 0;
+};
+
+/*
+	Read-only ZIP archive which is memory-mapped as a whole.
+	Only the central directory is read up front, entries are decompressed on demand.
+*/
+class zip_archive
+{
+	memory_mapped_file archive_file_;
+
+	// Keyed by the lower-cased entry name
+	std::unordered_map<std::string, zip_archive_entry> entries_;
+
+	void read_central_directory();
+
+	public:
+		explicit zip_archive(const std::filesystem::path& archive_file_path);
+
+		[[nodiscard]] const zip_archive_entry* find_entry(const std::string& entry_name) const;
+
+		bool load_entry_to_buffer(const zip_archive_entry& entry, std::vector<uint8_t>& buffer) const;
+};
\ No newline at end of file